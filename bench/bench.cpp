@@ -0,0 +1,246 @@
+// rscript_bench: compiles synthetic programs of growing size and times every compiler phase.
+// one JSON object is printed per corpus, size and phase:
+// {"corpus":"globals","size":1000,"run":0,"phase":"torbc","wall_ms":1.2,"cpu_ms":1.1,"allocations":5123,"peak_rss_kb":10240}
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <functional>
+#include <vector>
+#include "lexer.hpp"
+#include "rbc.hpp"
+#include "config.hpp"
+#include "context.hpp"
+#include "metrics.hpp"
+#include "getopt.h"
+
+RS_COUNT_ALLOCATIONS
+
+namespace fs = std::filesystem;
+
+struct corpus
+{
+    const char* name;
+    // writes the program for size n into dir, and returns the main file.
+    std::function<fs::path(const fs::path& dir, size_t n)> generate;
+};
+
+static fs::path write(const fs::path& path, const std::string& content)
+{
+    std::ofstream out(path);
+    out << content;
+    return path;
+}
+// identifiers can't contain digits, so numbers are spelled in letters: 0 -> a, 26 -> ba.
+// the prefix ends in '_' so no name is a keyword.
+static std::string ident(const char* prefix, size_t i)
+{
+    std::string letters;
+    do
+    {
+        letters.insert(letters.begin(), static_cast<char>('a' + i % 26));
+        i /= 26;
+    } while (i);
+    return prefix + letters;
+}
+
+static const std::vector<corpus> corpora =
+{
+    {"globals", [](const fs::path& dir, size_t n)
+    {
+        std::stringstream ss;
+        for (size_t i = 0; i < n; i++)
+            ss << ident("g_", i) << ": int = " << i << ";\n";
+        return write(dir / "globals.rsc", ss.str());
+    }},
+    {"functions", [](const fs::path& dir, size_t n)
+    {
+        std::stringstream ss;
+        for (size_t i = 0; i < n; i++)
+            ss << "method: void " << ident("f_", i) << "(a: int)\n{\n    b: int = a + " << i << ";\n    b = b * 2;\n}\n";
+        for (size_t i = 0; i < n; i++)
+            ss << ident("f_", i) << "(" << i << ");\n";
+        return write(dir / "functions.rsc", ss.str());
+    }},
+    {"modules", [](const fs::path& dir, size_t n)
+    {
+        // n functions spread over modules nested 8 deep, called through their full path.
+        const size_t depth = 8, perModule = std::max<size_t>(1, n / depth);
+        std::stringstream ss, calls;
+        std::string path;
+        for (size_t d = 0; d < depth; d++)
+        {
+            ss << "module " << ident("m_", d) << "\n{\n";
+            path += ident("m_", d) + "::";
+            for (size_t i = 0; i < perModule; i++)
+            {
+                ss << "method: void " << ident("f_", i) << "(a: int)\n{\n    b: int = a + " << i << ";\n}\n";
+                calls << path << ident("f_", i) << "(" << i << ");\n";
+            }
+        }
+        for (size_t d = 0; d < depth; d++)
+            ss << "}\n";
+        return write(dir / "modules.rsc", ss.str() + calls.str());
+    }},
+    {"expressions", [](const fs::path& dir, size_t n)
+    {
+        // one expression with n terms, and n / 8 statements of 8 terms.
+        std::stringstream ss;
+        ss << "x: int = 1;\ny: int = 2;\nz: int = x";
+        for (size_t i = 0; i < n; i++)
+            ss << (i % 3 == 0 ? " + " : i % 3 == 1 ? " - " : " * ") << (i % 2 ? "y" : std::to_string(i % 7 + 1));
+        ss << ";\n";
+        for (size_t i = 0; i < n / 8; i++)
+            ss << "z = z + x * " << i % 5 + 1 << " - y + " << i << " * x - 3 + y * 2;\n";
+        return write(dir / "expressions.rsc", ss.str());
+    }},
+    {"uses", [](const fs::path& dir, size_t n)
+    {
+        // a two level 'use' tree, every file is used once.
+        const size_t width = std::max<size_t>(1, n / 16);
+        std::stringstream main;
+        for (size_t i = 0; i < width; i++)
+        {
+            std::stringstream mid;
+            for (size_t j = 0; j < 4; j++)
+            {
+                const std::string leaf = ident("l_", i * 4 + j);
+                write(dir / (leaf + ".rsc"), "method: void " + leaf + "(a: int)\n{\n    b: int = a + 1;\n}\n");
+                mid << "use " << leaf << ";\n";
+            }
+            const std::string name = ident("u_", i);
+            mid << "method: void " << name << "()\n{\n    c: int = " << i << ";\n}\n";
+            write(dir / (name + ".rsc"), mid.str());
+            main << "use " << name << ";\n";
+        }
+        for (size_t i = 0; i < width; i++)
+            main << ident("u_", i) << "();\n";
+        return write(dir / "uses.rsc", main.str());
+    }},
+};
+
+static void report(const std::string& corpusName, size_t size, int run, const char* phase, const metrics::sample& s)
+{
+    std::cout << "{\"corpus\":\"" << corpusName << "\",\"size\":" << size << ",\"run\":" << run
+              << ",\"phase\":\"" << phase << "\",\"wall_ms\":" << s.wallMs << ",\"cpu_ms\":" << s.cpuMs
+              << ",\"allocations\":" << s.allocations << ",\"peak_rss_kb\":" << s.peakRssKb << "}" << std::endl;
+}
+
+// stdout only carries the JSON lines, errors go to stderr.
+static bool fail(const rs_error& error)
+{
+    std::cerr << error.fName << ':' << error.trace.line << ':' << error.trace.caret << ": " << error.message << std::endl;
+    return false;
+}
+
+// runs the same phases as rscript, returns false and prints the error if the corpus fails to compile.
+static bool compile(const fs::path& file, const fs::path& world, const std::string& corpusName, size_t size, int run)
+{
+    std::string fileName = file.string(), content;
+    {
+        std::ifstream in(file);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        content = ss.str();
+    }
+    rs_error error;
+
+    metrics::stopwatch watch;
+    token_list tokens = tlex(fileName, content, &error);
+    report(corpusName, size, run, "tlex", watch.stop());
+    if (error.trace.ec)
+        return fail(error);
+
+    watch = {};
+    preprocess(tokens, fileName, content, &error);
+    report(corpusName, size, run, "preprocess", watch.stop());
+    if (error.trace.ec)
+        return fail(error);
+
+    watch = {};
+    rbc_program bytecode = torbc(tokens, fileName, content, &error);
+    report(corpusName, size, run, "torbc", watch.stop());
+    if (error.trace.ec)
+        return fail(error);
+
+    std::string err;
+    watch = {};
+    mc_program program = tomc(bytecode, "redscript", err);
+    report(corpusName, size, run, "tomc", watch.stop());
+    if (!err.empty())
+        return std::cerr << err << std::endl, false;
+
+    watch = {};
+    writemc(program, corpusName, world.filename().string(), err);
+    report(corpusName, size, run, "writemc", watch.stop());
+    if (!err.empty())
+        return std::cerr << err << std::endl, false;
+    return true;
+}
+
+int main(int argc, char* const* argv)
+{
+    std::vector<size_t> sizes = {100, 1000, 5000};
+    std::string only;
+    int runs = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:c:r:")) != -1)
+    {
+        switch (opt)
+        {
+            case 's':
+            {
+                // -s 100,1000,10000
+                sizes.clear();
+                std::stringstream list(optarg);
+                std::string size;
+                while (std::getline(list, size, ','))
+                    sizes.push_back(std::stoull(size));
+                break;
+            }
+            case 'c':
+                only = optarg;
+                break;
+            case 'r':
+                runs = std::max(1, std::atoi(optarg));
+                break;
+            default:
+                std::cerr << "Usage: " << argv[0] << " [-s sizes,...] [-c corpus] [-r runs]" << std::endl;
+                return EXIT_FAILURE;
+        }
+    }
+
+    const fs::path root = fs::temp_directory_path() / "rscript_bench";
+    const fs::path world = root / "saves" / "bench";
+    fs::remove_all(root);
+    fs::create_directories(world);
+
+    // warnings would be printed between the JSON lines, they are only kept.
+    rs_context::current().echo = false;
+    RS_CONFIG.dict["mcpath"]    = (root / "saves").string();
+    RS_CONFIG.dict["versionid"] = MC_MACRO_PACK_FORMAT;
+
+    bool failed = false;
+    for (const corpus& c : corpora)
+    {
+        if (!only.empty() && only != c.name)
+            continue;
+        for (size_t size : sizes)
+        {
+            const fs::path dir = root / c.name / std::to_string(size);
+            fs::create_directories(dir);
+            const fs::path file = c.generate(dir, size);
+            for (int run = 0; run < runs; run++)
+            {
+                if (!compile(file, world, c.name, size, run))
+                {
+                    std::cerr << "corpus '" << c.name << "' (size " << size << ") failed to compile." << std::endl;
+                    failed = true;
+                    break;
+                }
+            }
+        }
+    }
+    fs::remove_all(root);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,2 +1,2 @@
-g++ -o rscript.exe src/*.cpp entry.cpp -I./src/libs -Isrc -g -std=c++20 -static -pipe
+g++ -o rscript.exe src/*.cpp entry.cpp -I./src/libs -Isrc -g -std=c++20 -pthread -static -pipe
 echo %ERRORLEVEL%
\ No newline at end of file
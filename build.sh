@@ -1,10 +1,10 @@
 echo Building...
 
 if [ "$1" == "-d" ]; then
-g++ -o rscript ./src/*.cpp entry.cpp -Isrc -std=c++20 -g -pipe
+g++ -o rscript ./src/*.cpp entry.cpp -Isrc -std=c++20 -pthread -g -pipe
 echo "Build done."
 gdb rscript
 else
-g++ -o rscript ./src/*.cpp entry.cpp -Isrc -std=c++20 -pipe
+g++ -o rscript ./src/*.cpp entry.cpp -Isrc -std=c++20 -pthread -pipe
 echo "Build done. (no debug symbols)"
 fi
\ No newline at end of file
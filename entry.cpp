@@ -1,11 +1,32 @@
 #include <iostream>
 #include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <thread>
 #include "lexer.hpp"
 #include "file.hpp"
 #include "logger.hpp"
 #include "rbc.hpp"
 #include "config.hpp"
+#include "profile.hpp"
+#include "compiler.hpp"
+#include "context.hpp"
+#include "pgo.hpp"
+#include "server.hpp"
+#include "metrics.hpp"
 #include "getopt.h"
+
+RS_COUNT_ALLOCATIONS
+
+// long options without a short form.
+enum long_only_option
+{
+    OPT_DUMP_TOKENS = 256,
+    OPT_EMIT_RBC,
+    OPT_PORT,
+    OPT_PGO,
+    OPT_COST_REPORT
+};
 int main(int argc, char* const* argv)
 {
     if (argc < 3) 
@@ -16,15 +37,85 @@ int main(int argc, char* const* argv)
 #pragma region ARGS
     char* fileName   = nullptr;
     const char* outFolder  = nullptr;
+    // -d turns on every debug dump.
     bool debug       = false;
+    bool dumpTokens  = false;
+    bool emitRbc     = false;
+    bool timeReport  = false;
+    const char* profileDump = nullptr;
+    const char* batchManifest = nullptr;
+    const char* serveManifest = nullptr;
+    const char* pgoProfile    = nullptr;
+    server::options serveOptions;
+    compiler::options compileOptions;
+    unsigned    jobs        = std::thread::hardware_concurrency();
+    static const option longOptions[] =
+    {
+        {"profile",        no_argument,       nullptr, 'p'},
+        {"profile-report", required_argument, nullptr, 'r'},
+        {"time-report",    no_argument,       nullptr, 't'},
+        {"dump-tokens",    no_argument,       nullptr, OPT_DUMP_TOKENS},
+        {"emit-rbc",       no_argument,       nullptr, OPT_EMIT_RBC},
+        {"debug",          no_argument,       nullptr, 'd'},
+        {"batch",          required_argument, nullptr, 'b'},
+        {"jobs",           required_argument, nullptr, 'j'},
+        {"serve",          required_argument, nullptr, 's'},
+        {"port",           required_argument, nullptr, OPT_PORT},
+        {"pgo",            required_argument, nullptr, OPT_PGO},
+        {"cost-report",    no_argument,       nullptr, OPT_COST_REPORT},
+        {nullptr,          0,                 nullptr, 0}
+    };
     int opt;
-    while ((opt = getopt(argc, argv, "f:o:d")) != -1)
+    while ((opt = getopt_long(argc, argv, "f:o:dptb:j:s:", longOptions, nullptr)) != -1)
     {
         switch (opt)
         {
             case 'd':
                 debug = true;
                 break;
+            case 'p':
+                compileOptions.profile = true;
+                break;
+            case OPT_COST_REPORT:
+                compileOptions.costReport = true;
+                break;
+            case 't':
+                timeReport = true;
+                break;
+            case 'b':
+                batchManifest = optarg;
+                break;
+            case 'j':
+                jobs = std::max(1, std::atoi(optarg));
+                break;
+            case 's':
+                serveManifest = optarg;
+                break;
+            case OPT_PORT:
+            {
+                int port = 0;
+                const char* end = optarg + std::strlen(optarg);
+                auto [last, ec] = std::from_chars(optarg, end, port);
+                if (ec != std::errc() || last != end || port < 1 || port > 65535)
+                {
+                    ERROR("Invalid port '%s', expected a number from 1 to 65535.", optarg);
+                    return EXIT_FAILURE;
+                }
+                serveOptions.port = static_cast<unsigned short>(port);
+                break;
+            }
+            case OPT_PGO:
+                pgoProfile = optarg;
+                break;
+            case OPT_DUMP_TOKENS:
+                dumpTokens = true;
+                break;
+            case OPT_EMIT_RBC:
+                emitRbc = true;
+                break;
+            case 'r':
+                profileDump = optarg;
+                break;
             case 'f':
                 fileName = optarg;
                 break;
@@ -37,6 +128,87 @@ int main(int argc, char* const* argv)
         }
     }
 
+    if (profileDump)
+    {
+        // rscript --profile-report <dump> <map> <profile.json>
+        if (optind + 2 > argc)
+        {
+            ERROR("Usage: %s --profile-report <dump> <map> <profile.json>, the map is the <name>.rsprof in the datapack folder.", argv[0]);
+            return EXIT_FAILURE;
+        }
+        std::string reportError;
+        if (!profiling::report(profileDump, argv[optind], argv[optind + 1], reportError))
+        {
+            ERROR("%s", reportError.c_str());
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+    // reads the --pgo profile into the current context, once the config is read.
+    auto loadProfile = [&]() -> bool
+    {
+        if (!pgoProfile)
+            return true;
+        auto counts = std::make_shared<pgo::profile>();
+        counts->hotPercent = RS_CONFIG.getOr<int>("pgo_hot_percent", counts->hotPercent);
+        if (counts->hotPercent < 1 || counts->hotPercent > 100)
+        {
+            ERROR("Config error: 'pgo_hot_percent' must be from 1 to 100.");
+            return false;
+        }
+        std::string profileError;
+        if (!pgo::read(pgoProfile, *counts, profileError))
+        {
+            ERROR("%s", profileError.c_str());
+            return false;
+        }
+        rs_context::current().profile = counts;
+        INFO("Using profile %s (%zu functions).", pgoProfile, counts->functions.size());
+        return true;
+    };
+    if (batchManifest || serveManifest)
+    {
+        // rscript --batch <manifest> [-j jobs]
+        // rscript --serve <manifest> [--port port]
+        rs_error error;
+        RS_CONFIG = readConfig(RS_CONFIG_LOCATION, &error);
+        if (error.trace.ec)
+        {
+            printerr(error);
+            return EXIT_FAILURE;
+        }
+        if (!loadProfile())
+            return EXIT_FAILURE;
+        std::string manifestError;
+        std::vector<compiler::job> batch = compiler::readManifest(batchManifest ? batchManifest : serveManifest, manifestError);
+        if (!manifestError.empty())
+        {
+            ERROR("%s", manifestError.c_str());
+            return EXIT_FAILURE;
+        }
+        if (serveManifest)
+        {
+            serveOptions.compile = compileOptions;
+            return server::serve(batch, serveOptions);
+        }
+        std::vector<compiler::result> results = compiler::compileAll(batch, jobs, compileOptions);
+
+        size_t failed = 0;
+        for (size_t b = 0; b < batch.size(); b++)
+        {
+            if (results[b].ok)
+                continue;
+            failed++;
+            ERROR("%s", results[b].error.c_str());
+        }
+        if (failed)
+        {
+            ERROR("%zu of %zu programs failed to compile.", failed, batch.size());
+            return EXIT_FAILURE;
+        }
+        SUCCESS("Compiled %zu programs.", batch.size());
+        return EXIT_SUCCESS;
+    }
     if (!fileName)
     {
         if (optind < argc)
@@ -58,7 +230,20 @@ int main(int argc, char* const* argv)
         }
     }
 
+    dumpTokens |= debug;
+    emitRbc    |= debug;
 #pragma endregion ARGS
+#pragma region TIMING
+    std::vector<std::pair<const char*, metrics::sample>> timings;
+    metrics::stopwatch watch;
+    // ends the current phase, and starts timing the next one.
+    auto lap = [&](const char* phase)
+    {
+        if (timeReport)
+            timings.push_back({phase, watch.stop()});
+        watch = {};
+    };
+#pragma endregion TIMING
     rs_error error;
 
     RS_CONFIG = readConfig(RS_CONFIG_LOCATION, &error);
@@ -67,90 +252,66 @@ int main(int argc, char* const* argv)
         printerr(error);
         return EXIT_FAILURE;
     }
-
-    std::string fContent = readFile(fileName);
-
-    if(fContent.length() == 0)
-    {
-        ERROR("Provided source file does not exist.");
+    if (!loadProfile())
         return EXIT_FAILURE;
-    }
-
-    token_list list = tlex(fileName, fContent, &error);
-
-    if (error.trace.ec)
-    {
-        printerr(error);
-        return EXIT_FAILURE;
-    }
-    INFO("Preprocessing...");
-
-    preprocess(list, fileName, fContent, &error);
-
-    if(error.trace.ec)
-    {
-        printerr(error);
-        return EXIT_FAILURE;
-    }
-
-    if(debug || 1)
-    {
-        INFO("Token Count: %zu", list.size());
-        for(token t : list)
-        {
-            std::cout << t.str() << std::endl;
-        }
-    }
-    
-    INFO("Compiling...");
-
-    rbc_program bytecode = torbc(list, fileName, fContent, &error);
+    lap("config");
 
-    if (error.trace.ec)
-    {
-        printerr(error);
-        return EXIT_FAILURE;
-    }
-    int i = 1;
-    if (debug || 1)
-    {
-        std::ofstream out("./out.rbc");
-        INFO("Writing global byte code to out.rbc...");
-        for(auto& function   : bytecode.functions)
+    compileOptions.phase = lap;
+    if (dumpTokens)
+        compileOptions.tokens = [&](const token_list& list)
         {
-            out << function.second->toHumanStr() << '\n';
-        }
-        for(rbc_command& instruction : bytecode.globalFunction.instructions)
+            INFO("Token Count: %zu", list.size());
+            for(token t : list)
+            {
+                std::cout << t.str() << std::endl;
+            }
+            watch = {};
+        };
+    if (emitRbc)
+        compileOptions.bytecode = [&](rbc_program& bytecode)
         {
-            INFO("[scope: GLOBAL] [%d] %s", i, instruction.tostr().c_str());
-            out << instruction.toHumanStr() << '\n';
-            i++;
-        }
-
-        out.close();
-
-    }
-    std::string conversionError = "";
-    std::string outFolderLower = outFolder;
+            std::ofstream out("./out.rbc");
+            INFO("Writing global byte code to out.rbc...");
+            for(auto& function   : bytecode.functions)
+            {
+                out << function.second->toHumanStr() << '\n';
+            }
+            int i = 1;
+            for(rbc_command& instruction : bytecode.globalFunction.instructions)
+            {
+                INFO("[scope: GLOBAL] [%d] %s", i, instruction.tostr().c_str());
+                out << instruction.toHumanStr() << '\n';
+                i++;
+            }
 
-    toLower(outFolderLower);
+            out.close();
+            watch = {};
+        };
 
-    // mc_program endProgram = tomc(bytecode, removeSpecialCharacters(outFolderLower), conversionError);
-    mc_program endProgram = tomc(bytecode, "redscript", conversionError);
-
-    if (!conversionError.empty())
+    INFO("Compiling...");
+    compiler::result compiled = compiler::compile({fileName, outFolder}, rs_context::current(), nullptr, compileOptions);
+    if (!compiled.ok)
     {
-        ERROR("%s", conversionError.c_str());
+        // errors that point into the source were printed when they were raised.
+        if (compiled.file.empty())
+            ERROR("%s", compiled.error.c_str());
         return EXIT_FAILURE;
     }
-    
-    std::string packageName = removeSpecialCharacters(std::filesystem::path(outFolder).filename().string());
-    writemc(endProgram, packageName, outFolderLower, conversionError);
+    if (compileOptions.profile)
+        INFO("Profiling counters added, map written next to the datapack as <name>.rsprof.");
 
-    if (!conversionError.empty())
+    if (timeReport)
     {
-        ERROR("Error while writing: %s", conversionError.c_str());
-        return EXIT_FAILURE;
+        metrics::sample total;
+        printf("%-12s %10s %10s %12s %14s\n", "phase", "wall ms", "cpu ms", "allocations", "peak rss KiB");
+        for (auto& [phase, sample] : timings)
+        {
+            printf("%-12s %10.2f %10.2f %12zu %14ld\n", phase, sample.wallMs, sample.cpuMs, sample.allocations, sample.peakRssKb);
+            total.wallMs      += sample.wallMs;
+            total.cpuMs       += sample.cpuMs;
+            total.allocations += sample.allocations;
+        }
+        printf("%-12s %10.2f %10.2f %12zu %14ld\n", "total", total.wallMs, total.cpuMs, total.allocations, metrics::peakRssKb());
     }
     SUCCESS("Compiled successfully to %s.", outFolder);
     return EXIT_SUCCESS;
@@ -0,0 +1,176 @@
+// rscript_sim: runs a compiled program without minecraft and counts the commands it executes.
+// the program is either a .rsc file, compiled in memory, or a datapack folder rscript wrote.
+// one JSON object is printed per function run, then one per tick while scheduled functions remain:
+// {"function":"redscript:main","tick":0,"commands":812,"truncated":false,"returned":false,"value":0,"output":["hi"]}
+// with -b, the bytecode of a .rsc is also run by the rbc interpreter, and one more object tells whether it
+// printed the same as the global function:
+// {"function":"<rbc>","instructions":240,"truncated":false,"output":["hi"],"matches":true}
+#include <iostream>
+#include <filesystem>
+#include <vector>
+#include "config.hpp"
+#include "file.hpp"
+#include "context.hpp"
+#include "compiler.hpp"
+#include "sim.hpp"
+#include "interp.hpp"
+#include "getopt.h"
+
+namespace fs = std::filesystem;
+
+static std::string quote(const std::string& s)
+{
+    std::string quoted = "\"";
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            quoted += '\\';
+        if (c == '\n')
+        {
+            quoted += "\\n";
+            continue;
+        }
+        quoted += c;
+    }
+    return quoted + '"';
+}
+
+// compiles file like rscript does, without writing it. returns false and prints the error on failure.
+// with interpreted, the bytecode is run before tomc rewrites it.
+static bool compile(const std::string& file, mc_program& program, interp::run_result* interpreted, std::vector<std::string>* printed)
+{
+    rs_error error;
+    if (fs::exists(RS_CONFIG_LOCATION))
+    {
+        RS_CONFIG = readConfig(RS_CONFIG_LOCATION, &error);
+        if (error.trace.ec)
+            return std::cerr << error.message << std::endl, false;
+    }
+    // stdout is only JSON, warnings and errors go to stderr once compiling is done.
+    rs_context& context = rs_context::current();
+    context.echo = false;
+    struct flush
+    {
+        rs_context& context;
+        ~flush()
+        {
+            for (const rs_diagnostic& d : context.diagnostics)
+                std::cerr << (d.level == RS_LOG_WARN ? "[WARN] " : "[ERROR] ") << d.message << std::endl;
+        }
+    } warnings{context};
+
+    compiler::options options;
+    if (interpreted)
+        options.bytecode = [&](rbc_program& bytecode)
+        {
+            interp::interpreter interpreter(bytecode);
+            *interpreted = interpreter.run();
+            *printed     = interpreter.output;
+        };
+    compiler::result built = compiler::build(file, context, program, options);
+    if (!built.ok && built.file.empty())
+        std::cerr << built.error << std::endl;
+    return built.ok;
+}
+
+static void report(const std::string& location, long long tick, const sim::run_result& result, sim::machine& machine, size_t firstOutput)
+{
+    std::cout << "{\"function\":" << quote(location) << ",\"tick\":" << tick << ",\"commands\":" << result.commands
+              << ",\"truncated\":" << (result.truncated ? "true" : "false")
+              << ",\"returned\":" << (result.returned ? "true" : "false") << ",\"value\":" << result.value
+              << ",\"output\":[";
+    for (size_t i = firstOutput; i < machine.output.size(); i++)
+        std::cout << (i > firstOutput ? "," : "") << quote(machine.output[i]);
+    std::cout << ']';
+    if (!result.error.empty())
+        std::cout << ",\"error\":" << quote(result.error);
+    std::cout << '}' << std::endl;
+}
+
+int main(int argc, char* const* argv)
+{
+    std::vector<std::string> entries;
+    long long ticks = 0;
+    bool bytecode = false;
+    sim::options options;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:t:n:b")) != -1)
+    {
+        switch (opt)
+        {
+            case 'f':
+                entries.push_back(optarg);
+                break;
+            case 't':
+                ticks = std::max(0LL, std::atoll(optarg));
+                break;
+            case 'n':
+                options.maxCommands = std::max(1LL, std::atoll(optarg));
+                break;
+            case 'b':
+                bytecode = true;
+                break;
+            default:
+                std::cerr << "Usage: " << argv[0] << " <main.rsc | datapack> [-f namespace:function]... [-t ticks] [-n max commands] [-b]" << std::endl;
+                return EXIT_FAILURE;
+        }
+    }
+    if (optind >= argc)
+    {
+        std::cerr << "Usage: " << argv[0] << " <main.rsc | datapack> [-f namespace:function]... [-t ticks] [-n max commands] [-b]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const fs::path input = argv[optind];
+
+    sim::machine machine(options);
+    interp::run_result interpreted;
+    std::vector<std::string> printed;
+    // the global function of a program is named after it, like the datapack rscript writes.
+    const std::string name = removeSpecialCharacters(input.stem().string());
+    if (fs::is_directory(input))
+    {
+        std::string err;
+        if (!machine.load(input, err))
+            return std::cerr << err << std::endl, EXIT_FAILURE;
+    }
+    else
+    {
+        mc_program program;
+        if (!compile(input.string(), program, bytecode ? &interpreted : nullptr, &printed))
+            return EXIT_FAILURE;
+        machine.load(program, "redscript", name);
+    }
+    if (entries.empty())
+        entries.push_back("redscript:" + name);
+
+    bool failed = false;
+    for (const std::string& entry : entries)
+    {
+        const size_t firstOutput = machine.output.size();
+        sim::run_result result = machine.run(entry);
+        report(entry, 0, result, machine, firstOutput);
+        failed |= !result.ok;
+        if (!bytecode || fs::is_directory(input) || entry != "redscript:" + name)
+            continue;
+        const bool matches = std::equal(printed.begin(), printed.end(), machine.output.begin() + firstOutput, machine.output.end());
+        std::cout << "{\"function\":\"<rbc>\",\"instructions\":" << interpreted.instructions
+                  << ",\"truncated\":" << (interpreted.truncated ? "true" : "false") << ",\"output\":[";
+        for (size_t i = 0; i < printed.size(); i++)
+            std::cout << (i ? "," : "") << quote(printed[i]);
+        std::cout << "],\"matches\":" << (matches ? "true" : "false");
+        if (!interpreted.error.empty())
+            std::cout << ",\"error\":" << quote(interpreted.error);
+        std::cout << '}' << std::endl;
+        failed |= !interpreted.ok || !matches;
+    }
+    for (long long tick = 1; tick <= ticks && machine.pending(); tick++)
+    {
+        const size_t firstOutput = machine.output.size();
+        for (auto& [location, result] : machine.tick())
+        {
+            report(location, tick, result, machine, firstOutput);
+            failed |= !result.ok;
+        }
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,24 @@
+# runs SAMPLE in sim/tests and again in sim/tests/legacy, a pack format without macros or return run,
+# each against the interpreter, and fails unless both pass and print the same output.
+foreach(dir modern legacy)
+    if(dir STREQUAL "modern")
+        set(cwd ${CMAKE_CURRENT_LIST_DIR})
+        set(file ${SAMPLE}.rsc)
+    else()
+        set(cwd ${CMAKE_CURRENT_LIST_DIR}/legacy)
+        set(file ../${SAMPLE}.rsc)
+    endif()
+    execute_process(COMMAND ${SIM} ${ARGS} ${file} WORKING_DIRECTORY ${cwd}
+                    RESULT_VARIABLE code OUTPUT_VARIABLE out ERROR_VARIABLE err)
+    if(NOT code EQUAL 0)
+        message(FATAL_ERROR "${SAMPLE} failed under the ${dir} config:\n${out}${err}")
+    endif()
+    string(REGEX MATCHALL "\"output\":\\[[^\n]*\\]" ${dir}_output "${out}")
+    if(${dir}_output STREQUAL "")
+        message(FATAL_ERROR "${SAMPLE} printed no output under the ${dir} config:\n${out}")
+    endif()
+endforeach()
+if(NOT modern_output STREQUAL legacy_output)
+    message(FATAL_ERROR "${SAMPLE} output differs:\n${modern_output}\n${legacy_output}")
+endif()
+message(STATUS "${SAMPLE}: ${legacy_output}")
@@ -0,0 +1,185 @@
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "compiler.hpp"
+#include "rbc.hpp"
+#include "cost.hpp"
+#include "profile.hpp"
+#include "file.hpp"
+
+namespace compiler
+{
+    // printerr writes several lines, keep errors from different threads apart.
+    static std::mutex printLock;
+
+    std::vector<job> readManifest(const std::filesystem::path& path, std::string& err)
+    {
+        std::vector<job> jobs;
+        std::ifstream in(path);
+        if (!in)
+        {
+            err = "Could not read batch manifest '" + path.string() + "'.";
+            return jobs;
+        }
+        std::string line;
+        size_t number = 0;
+        while (std::getline(in, line))
+        {
+            number++;
+            std::stringstream fields(line);
+            job j;
+            if (!(fields >> j.source) || j.source.starts_with('#'))
+                continue;
+            if (!(fields >> j.world))
+            {
+                err = "Manifest line " + std::to_string(number) + " has no output world: '" + line + "'.";
+                return {};
+            }
+            jobs.push_back(j);
+        }
+        return jobs;
+    }
+    result build(const std::string& source, rs_context& context, mc_program& program, const options& opts)
+    {
+        rs_context_scope scope(context);
+        const size_t firstDiagnostic = context.diagnostics.size();
+        auto visited = std::make_shared<std::vector<std::filesystem::path>>();
+        visited->push_back(std::filesystem::absolute(source));
+        auto phase = [&](const char* name)
+        {
+            if (opts.phase)
+                opts.phase(name);
+        };
+
+        auto fail = [&](const std::string& message)
+        {
+            result failed;
+            failed.error = source + ": " + message;
+            failed.files = *visited;
+            failed.diagnostics.assign(context.diagnostics.begin() + firstDiagnostic, context.diagnostics.end());
+            return failed;
+        };
+        auto failTrace = [&](rs_error& error)
+        {
+            {
+                std::lock_guard<std::mutex> guard(printLock);
+                context.report(error);
+            }
+            result failed = fail(error.message);
+            failed.file   = error.fName;
+            failed.line   = error.trace.line;
+            failed.column = error.trace.caret;
+            return failed;
+        };
+
+        rs_error error;
+        std::string content = readFile(source);
+        if (content.empty())
+            return fail("source file does not exist.");
+        phase("read");
+
+        token_list tokens = tlex(source, content, &error);
+        if (error.trace.ec)
+            return failTrace(error);
+        phase("lex");
+
+        preprocess(tokens, source, content, &error, visited, context.cache.get());
+        if (error.trace.ec)
+            return failTrace(error);
+        phase("preprocess");
+        if (opts.tokens)
+            opts.tokens(tokens);
+
+        rbc_program bytecode = torbc(tokens, source, content, &error);
+        if (error.trace.ec)
+            return failTrace(error);
+        phase("torbc");
+        if (opts.bytecode)
+            opts.bytecode(bytecode);
+
+        std::string err;
+        program = tomc(bytecode, "redscript", err);
+        if (!err.empty())
+            return fail(err);
+        for (const std::filesystem::path& file : *visited)
+            program.sources.push_back(file.string());
+        phase("tomc");
+
+        analysis::cost_report costs = analysis::estimate(program, "redscript");
+        if (!analysis::checkBudgets(program, costs, "redscript", RS_CONFIG.getOr<int>("max_command_chain", 65536), err))
+            return fail(err);
+        phase("analysis");
+
+        result built;
+        built.ok    = true;
+        built.files = *visited;
+        built.diagnostics.assign(context.diagnostics.begin() + firstDiagnostic, context.diagnostics.end());
+        return built;
+    }
+    result compile(const job& j, rs_context& context, mc_write_state* written, const options& opts)
+    {
+        mc_program program;
+        result compiled = build(j.source, context, program, opts);
+        if (!compiled.ok)
+            return compiled;
+
+        rs_context_scope scope(context);
+        auto fail = [&](const std::string& message)
+        {
+            compiled.ok    = false;
+            compiled.error = j.source + ": " + message;
+            return compiled;
+        };
+        // reports are written next to the datapack, so programs of a batch don't overwrite each other's.
+        const std::string name = removeSpecialCharacters(std::filesystem::path(j.world).filename().string());
+        std::string world = j.world, err;
+        toLower(world);
+        const std::filesystem::path folder = datapackFolder(name, world);
+
+        if (opts.profile)
+        {
+            profiling::instrument(program, "redscript");
+            if (opts.phase)
+                opts.phase("profile");
+        }
+
+        writemc(program, name, world, err, written);
+        if (!err.empty())
+            return fail("Error while writing: " + err);
+        if (opts.phase)
+            opts.phase("writemc");
+
+        // estimated again, so the report counts the profiling counters that were written too.
+        if (opts.costReport && !analysis::writeReport(program, analysis::estimate(program, "redscript"), "redscript",
+                                                      (folder / (folder.filename().string() + ".rscost")).string(), err))
+            return fail(err);
+        if (opts.profile && !profiling::writeMap(program, "redscript", (folder / (folder.filename().string() + ".rsprof")).string(), err))
+            return fail(err);
+        return compiled;
+    }
+    std::vector<result> compileAll(const std::vector<job>& jobs, unsigned threads, const options& opts)
+    {
+        std::vector<result> results(jobs.size());
+        const rs_context& parent = rs_context::current();
+        std::atomic<size_t> next{0};
+
+        auto worker = [&]()
+        {
+            for (size_t i; (i = next.fetch_add(1)) < jobs.size();)
+            {
+                rs_context context = parent.fork();
+                results[i] = compile(jobs[i], context, nullptr, opts);
+            }
+        };
+
+        threads = std::max(1u, std::min<unsigned>(threads, jobs.size()));
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; t++)
+            pool.emplace_back(worker);
+        worker();
+        for (std::thread& thread : pool)
+            thread.join();
+        return results;
+    }
+}
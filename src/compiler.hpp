@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <functional>
+#include "context.hpp"
+#include "mc.hpp"
+#include "rbc.hpp"
+
+// compiling many programs in one process.
+namespace compiler
+{
+    // one program of a batch: the entry file and the world it is written to.
+    struct job
+    {
+        std::string source;
+        std::string world;
+    };
+    struct result
+    {
+        bool ok = false;
+        // compile errors are printed as they happen, this is kept for the summary.
+        std::string error = "";
+        // where the error is, when it points into the source.
+        std::string file  = "";
+        size_t line = 0, column = 0;
+        // the entry file and every file it uses.
+        std::vector<std::filesystem::path> files;
+        // warnings and errors raised while compiling this program.
+        std::vector<rs_diagnostic> diagnostics;
+    };
+
+    // what a compile does besides lexing, compiling and writing. the same for rscript, --batch, --serve and rscript_sim.
+    struct options
+    {
+        // adds profiling counters, and writes the map of them as <name>.rsprof into the datapack folder.
+        bool profile    = false;
+        // writes the command estimate of every function as <name>.rscost into the datapack folder.
+        bool costReport = false;
+        // called with the preprocessed tokens, and with the byte code before tomc rewrites it.
+        std::function<void(const token_list&)> tokens;
+        std::function<void(rbc_program&)> bytecode;
+        // called with the name of every phase when it ends.
+        std::function<void(const char*)> phase;
+    };
+
+    // reads a manifest of '<entry.rsc> <world>' lines. blank lines and lines starting with '#' are skipped.
+    std::vector<job> readManifest(const std::filesystem::path& path, std::string& err);
+
+    // lexes and compiles source into program, and checks its budgets, without writing anything.
+    // context is made current for the duration.
+    result build(const std::string& source, rs_context& context, mc_program& program, const options& opts = {});
+
+    // builds one program with the config and lex cache of context and writes it to the world of j.
+    // safe to call from several threads as long as each passes its own context.
+    // with a write state, only the files that changed since the last compile are written.
+    result compile(const job& j, rs_context& context, mc_write_state* written = nullptr, const options& opts = {});
+
+    // compiles every job on up to threads threads, each in a fork of the current context, so they share
+    // its config and lex cache. results are in the order of jobs.
+    std::vector<result> compileAll(const std::vector<job>& jobs, unsigned threads, const options& opts = {});
+}
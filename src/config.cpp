@@ -33,9 +33,11 @@ rs_config readConfig(const std::string& path, rs_error* err)
         std::string value;
         if (end == iter) value = "";
         else             value = content.substr(iter + 1, end - iter + 1);
-        if (value.back() == '\n')
+        if (!value.empty() && value.back() == '\n')
             value.pop_back();
-        if (std::isdigit(value.at(0)))
+        // negative ints are ints too, so they can be reported rather than read as strings.
+        const size_t digit = !value.empty() && value.front() == '-' ? 1 : 0;
+        if (digit < value.size() && std::isdigit(static_cast<unsigned char>(value.at(digit))))
         {
             try{
                 config.dict.insert_or_assign(flag, std::stoi(value));
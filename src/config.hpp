@@ -22,6 +22,15 @@ struct rs_config
     {
         return dict.find(s) != dict.end();
     }
+    // returns the value of s, or fallback if it is not set or of another type.
+    template<typename _V>
+    inline _V getOr(const std::string& s, _V fallback) const
+    {
+        auto f = dict.find(s);
+        if (f == dict.end() || !std::holds_alternative<_V>(f->second))
+            return fallback;
+        return std::get<_V>(f->second);
+    }
 };
 
 rs_config readConfig(const std::string& path, rs_error* err);
\ No newline at end of file
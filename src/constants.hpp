@@ -10,6 +10,8 @@
 #define RS_SELECTOR_KW_ID 6
 #define RS_BOOL_KW_ID 7
 #define RS_NULL_KW_ID 8
+// map<string, T>, no literal has this type.
+#define RS_MAP_KW_ID 9
 #define RS_VOID_KW_ID -1
 #define RS_LANG_KEYWORDS {{"true", {token_type::KW_TRUE,0}}, \
     {"false", {token_type::KW_FALSE,0}}, \
@@ -20,6 +22,7 @@
     {"list", {token_type::TYPE_DEF, RS_LIST_KW_ID}}, \
     {"object", {token_type::TYPE_DEF, RS_OBJECT_KW_ID}}, \
     {"selector", {token_type::TYPE_DEF, RS_SELECTOR_KW_ID}}, \
+    {"map", {token_type::TYPE_DEF, RS_MAP_KW_ID}}, \
     {"null", {token_type::KW_NULL, RS_NULL_KW_ID}}, \
     {"void", {token_type::TYPE_DEF, RS_VOID_KW_ID}}, \
     {"return", {token_type::KW_RETURN,0}}, \
@@ -34,6 +37,7 @@
     {"break", {token_type::KW_BREAK,0}}, \
     {"in", {token_type::KW_IN,0}}, \
     {"continue", {token_type::KW_CONTINUE,0}}, \
+    {"yield", {token_type::KW_YIELD,0}}, \
     {"use", {token_type::KW_USE,0}}, \
     {"if", {token_type::KW_IF,0}}, \
     {"else", {token_type::KW_ELSE,0}}, \
@@ -0,0 +1,66 @@
+#include <cstdarg>
+#include "context.hpp"
+
+// the context rscript itself compiles in, and the one every thread starts in.
+static rs_context processContext;
+static thread_local rs_context* activeContext = nullptr;
+
+rs_context& rs_context::current()
+{
+    return activeContext ? *activeContext : processContext;
+}
+rs_config& currentConfig()
+{
+    return rs_context::current().config;
+}
+
+rs_context rs_context::fork() const
+{
+    rs_context forked;
+    forked.config  = config;
+    forked.cache   = cache;
+    forked.profile = profile;
+    forked.echo    = echo;
+    return forked;
+}
+void rs_context::report(rs_error& error)
+{
+    rs_diagnostic diagnostic;
+    diagnostic.level   = RS_LOG_ERROR;
+    diagnostic.message = error.message;
+    diagnostic.file    = error.fName;
+    diagnostic.line    = error.trace.line;
+    diagnostic.column  = error.trace.caret;
+    diagnostics.push_back(diagnostic);
+    if (echo)
+        printerr(error);
+}
+
+rs_context_scope::rs_context_scope(rs_context& context) : _previous(activeContext)
+{
+    activeContext = &context;
+}
+rs_context_scope::~rs_context_scope()
+{
+    activeContext = _previous;
+}
+
+void rs_log(rs_log_level level, const char* prefix, const char* suffix, const char* format, ...)
+{
+    va_list args, copy;
+    va_start(args, format);
+    va_copy(copy, args);
+    const int length = std::vsnprintf(nullptr, 0, format, copy);
+    va_end(copy);
+    std::string message(length > 0 ? length : 0, '\0');
+    std::vsnprintf(message.data(), message.size() + 1, format, args);
+    va_end(args);
+
+    rs_context& context = rs_context::current();
+    rs_diagnostic diagnostic;
+    diagnostic.level   = level;
+    diagnostic.message = message;
+    context.diagnostics.push_back(diagnostic);
+    if (context.echo)
+        printf("%s%s%s", prefix, message.c_str(), suffix);
+}
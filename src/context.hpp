@@ -0,0 +1,54 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "config.hpp"
+#include "lexer.hpp"
+#include "pgo.hpp"
+
+// a warning or error raised while compiling.
+struct rs_diagnostic
+{
+    rs_log_level level = RS_LOG_WARN;
+    std::string message = "";
+    // empty when the diagnostic doesn't point into a source file.
+    std::string file    = "";
+    size_t line = 0, column = 0;
+};
+
+// everything one compilation reads and produces besides its program: config, lexed files and diagnostics.
+// the compiler only ever sees the context that is current on its thread (see rs_context_scope), so
+// programs compiled under different contexts can be compiled on different threads at once.
+class rs_context
+{
+public:
+    rs_config config;
+    // may be shared by contexts that read the same files.
+    std::shared_ptr<lex_cache> cache = std::make_shared<lex_cache>();
+    std::vector<rs_diagnostic> diagnostics;
+    // execution counts that guide tomc, none by default.
+    std::shared_ptr<const pgo::profile> profile;
+    // print diagnostics as they are raised. when off, they are only kept.
+    bool echo = true;
+
+    // a context with the same config and cache, and no diagnostics.
+    rs_context fork() const;
+    // keeps error, and prints it if echo is on.
+    void report(rs_error& error);
+
+    // the context of this thread. outside of any scope, the process wide one used by rscript.
+    static rs_context& current();
+};
+
+// makes a context current on this thread until the scope ends.
+class rs_context_scope
+{
+public:
+    explicit rs_context_scope(rs_context& context);
+    ~rs_context_scope();
+    rs_context_scope(const rs_context_scope&) = delete;
+    rs_context_scope& operator=(const rs_context_scope&) = delete;
+
+private:
+    rs_context* _previous;
+};
@@ -0,0 +1,187 @@
+#include <fstream>
+#include <functional>
+#include "cost.hpp"
+#include "logger.hpp"
+
+namespace analysis
+{
+    struct call
+    {
+        // full location, or the part before '$(' for macro calls.
+        std::string target;
+        bool dynamic = false;
+    };
+    // functions run by a command this tick. 'schedule function' is left out, it runs on a later tick.
+    static std::vector<call> calls(const std::string& body)
+    {
+        std::vector<call> found;
+        size_t at = 0;
+        while ((at = body.find("function ", at)) != std::string::npos)
+        {
+            const size_t start = at + 9;
+            const bool scheduled = at >= 9 && body.compare(at - 9, 9, "schedule ") == 0;
+            const bool word = at == 0 || body.at(at - 1) == ' ' || body.at(at - 1) == '$';
+            at = start;
+            if (scheduled || !word)
+                continue;
+
+            const size_t end = std::min(body.find(' ', start), body.size());
+            std::string target = body.substr(start, end - start);
+            if (target.find(':') == std::string::npos)
+                continue;
+            const size_t macro = target.find("$(");
+            if (macro != std::string::npos)
+                found.push_back({target.substr(0, macro), true});
+            else
+                found.push_back({target, false});
+        }
+        return found;
+    }
+    static bool conditionalReturn(const std::string& body)
+    {
+        return (body.starts_with("execute") || body.starts_with("$execute")) && body.find(" run return") != std::string::npos;
+    }
+    static bool unconditionalReturn(const std::string& body)
+    {
+        return body.starts_with("return") || body.starts_with("$return");
+    }
+    // 'execute as' and 'execute at' run the rest of the command once per entity found.
+    static bool perEntity(const std::string& body)
+    {
+        return body.find("execute as @") != std::string::npos || body.find("execute at @") != std::string::npos ||
+               body.find(" as @") != std::string::npos || body.find(" at @") != std::string::npos;
+    }
+    cost_report estimate(const mc_program& program, const std::string& ns)
+    {
+        std::unordered_map<std::string, const mc_function*> byLocation;
+        for (const mc_function& function : program.functions)
+            byLocation[function.location(ns)] = &function;
+
+        cost_report report;
+        std::unordered_map<std::string, bool> visiting;
+
+        std::function<function_cost(const std::string&, const mccmdlist&)> visit;
+
+        auto callee = [&](const std::string& location) -> function_cost
+        {
+            auto done = report.find(location);
+            if (done != report.end())
+                return done->second;
+            if (visiting[location])
+                return function_cost{0, true, "recursive through " + location};
+
+            auto found = byLocation.find(location);
+            // not part of this program (extern), only the calling command is counted.
+            if (found == byLocation.end())
+                return function_cost{};
+            return visit(location, found->second->commands);
+        };
+        // the most expensive function a command can run this tick.
+        auto commandCost = [&](const mc_command& cmd) -> function_cost
+        {
+            function_cost worst{1};
+            for (const call& c : calls(cmd.body))
+            {
+                function_cost cost;
+                if (c.dynamic)
+                {
+                    // any function under the macro's prefix can be picked at runtime.
+                    for (auto& [location, function] : byLocation)
+                    {
+                        if (!location.starts_with(c.target))
+                            continue;
+                        function_cost option = callee(location);
+                        if (option.unbounded)
+                        {
+                            cost = option;
+                            break;
+                        }
+                        cost.commands = std::max(cost.commands, option.commands);
+                    }
+                }
+                else cost = callee(c.target);
+
+                if (cost.unbounded)
+                    return cost;
+                worst.commands += cost.commands;
+            }
+            if (worst.commands > 1 && perEntity(cmd.body))
+                return function_cost{0, true, "calls a function once per entity: " + cmd.body};
+            return worst;
+        };
+
+        visit = [&](const std::string& location, const mccmdlist& commands) -> function_cost
+        {
+            visiting[location] = true;
+
+            // worst case from the back: a conditional return either ends here or carries on.
+            function_cost rest;
+            for (auto it = commands.rbegin(); it != commands.rend(); ++it)
+            {
+                function_cost cost = commandCost(*it);
+                if (cost.unbounded)
+                {
+                    rest = cost;
+                    break;
+                }
+                if (unconditionalReturn(it->body))
+                    rest.commands = cost.commands;
+                else if (conditionalReturn(it->body))
+                    rest.commands = std::max(cost.commands, 1 + rest.commands);
+                else
+                    rest.commands += cost.commands;
+            }
+            visiting[location] = false;
+            report[location] = rest;
+            return rest;
+        };
+
+        visit(RS_GLOBAL_SOURCE_NAME, program.globalFunction.commands);
+        for (const mc_function& function : program.functions)
+            callee(function.location(ns));
+        return report;
+    }
+    bool writeReport(const mc_program& program, const cost_report& report, const std::string& ns,
+                     const std::string& path, std::string& err)
+    {
+        std::ofstream out(path);
+        if (!out)
+        {
+            err = "Could not write cost report to '" + path + "'.";
+            return false;
+        }
+        auto line = [&](const std::string& location, const std::string& source)
+        {
+            const function_cost& cost = report.at(location);
+            out << location << '\t' << source << '\t'
+                << (cost.unbounded ? "unbounded" : std::to_string(cost.commands)) << '\t' << cost.reason << '\n';
+        };
+        line(RS_GLOBAL_SOURCE_NAME, program.globalFunction.source);
+        for (const mc_function& function : program.functions)
+            line(function.location(ns), function.source);
+        return true;
+    }
+    bool checkBudgets(const mc_program& program, const cost_report& report, const std::string& ns,
+                      long long maxChainLength, std::string& err)
+    {
+        for (const mc_function& function : program.functions)
+        {
+            const function_cost& cost = report.at(function.location(ns));
+            if (function.budget >= 0)
+            {
+                if (cost.unbounded)
+                    err += "Function '" + function.source + "' has a budget of " + std::to_string(function.budget) +
+                           " commands, but its cost can't be bounded (" + cost.reason + ").\n";
+                else if (cost.commands > function.budget)
+                    err += "Function '" + function.source + "' can run " + std::to_string(cost.commands) +
+                           " commands, over its budget of " + std::to_string(function.budget) + ".\n";
+            }
+            else if (!function.internal() && !cost.unbounded && cost.commands > maxChainLength)
+                WARN("Function '%s' can run %lld commands, over the command chain limit of %lld.",
+                     function.source.c_str(), cost.commands, maxChainLength);
+        }
+        if (!err.empty())
+            err.pop_back();
+        return err.empty();
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include "mc.hpp"
+
+// static estimate of how many commands a function can run in one tick, callees included.
+namespace analysis
+{
+    struct function_cost
+    {
+        // worst case commands run, only meaningful when bounded.
+        long long commands = 0;
+        bool unbounded     = false;
+        // why the function is unbounded.
+        std::string reason = "";
+    };
+    // keyed by function location. the global function is keyed by RS_GLOBAL_SOURCE_NAME.
+    typedef std::unordered_map<std::string, function_cost> cost_report;
+
+    // walks the call graph from every function. a call counts its callee, a conditional 'return' counts
+    // whichever of its two paths costs more, and recursion (which is how loops compile) is unbounded.
+    // 'schedule function' runs on a later tick and is not counted.
+    cost_report estimate(const mc_program& program, const std::string& ns);
+
+    // writes one line per function: '<location>\t<source>\t<commands|unbounded>\t<reason>'.
+    bool writeReport(const mc_program& program, const cost_report& report, const std::string& ns,
+                     const std::string& path, std::string& err);
+
+    // fails when a function with a budget can exceed it, or can't be bounded at all.
+    // functions that can exceed the command chain limit are warned about.
+    bool checkBudgets(const mc_program& program, const cost_report& report, const std::string& ns,
+                      long long maxChainLength, std::string& err);
+}
@@ -4,7 +4,7 @@ void printerr(rs_error& error)
 {
     std::stringstream fileStr;
     fileStr << error.fName << ':' << error.trace.line << ':' << error.trace.caret;
-    ERROR("[RS:%d] %s", error.trace.ec, error.message.c_str());
+    printf(ERROR_COLOR "[ERROR] [RS:%d] %s" ERROR_RESET "\n", error.trace.ec, error.message.c_str());
     std::cout << "\n\n\t -- " << fileStr.str() << " -- \n\n";
     for(size_t i = 0; i < std::min(error.trace.line - RS_ERROR_LINE_PADDING + 1, (size_t)RS_ERROR_LINE_PADDING); i++)
         std::cout << "      |\n";
@@ -13,6 +13,13 @@ struct raw_trace_info
 {
     size_t at = 0, line = 0, caret = 0, nlindex = 0;
     long long start = -1;
+    // index of the file the token came from in the files used by the program, 0 is the entry file.
+    uint32_t file = 0;
+};
+// where a command came from, for source maps. line is 0 when unknown.
+struct source_location
+{
+    uint32_t file = 0, line = 0, column = 0;
 };
 
 struct stack_trace
@@ -24,7 +31,7 @@ struct stack_trace
 
     operator raw_trace_info ()
     {
-        return raw_trace_info{*at, line, caret, nlindex, start};
+        return raw_trace_info{*at, line, caret, nlindex, start, 0};
     }
 };
 struct rs_error
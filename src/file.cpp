@@ -2,7 +2,7 @@
 
 std::string readFile(const std::filesystem::path& path)
 {
-    std::fstream stream(path);
+    std::ifstream stream(path);
 
     if(!stream.good()) return std::string();
 
@@ -16,6 +16,15 @@
 #define RBC_REGISTER_PLAYER_OBJ "alu"
 #define RBC_COMPARISON_RESULT_REGISTER "cmp"
 #define MC_DATAPACK_FOLDER "datapacks"
+#define MC_GENERATED_FOLDER "_gen"
+#define MC_PROFILE_FOLDER "_profile"
+#define RS_PROFILE_STORAGE RS_STORAGE_NAME ":" MC_PROFILE_FOLDER
+#define RS_PROFILE_OBJECTIVE "_rsprof"
+#define RS_GLOBAL_SOURCE_NAME "<global>"
+// first pack format with function macros (1.20.2).
+#define MC_MACRO_PACK_FORMAT 18
+// first pack format with return run (1.20.3).
+#define MC_RETURN_RUN_PACK_FORMAT 26
 #define MC_MCMETA_FILE_NAME "pack.mcmeta"
 #define MC_TEMP_STORAGE_NAME "temp"
 #define RBC_VALUE_T std::variant<rbc_constant, \
@@ -26,4 +35,6 @@
                       std::shared_ptr<void>>
 #define RS_PROGRAM_DATA_DEFAULT "{\"" RS_PROGRAM_VARIABLES "\":[], \"" RS_PROGRAM_REGISTERS "\":[], \"" RS_PROGRAM_DATA "\":{}, \"" RS_PROGRAM_STACK "\":[], \"" RS_PROGRAM_RETURN_REGISTER "\": 0, \"temp\": 0}"
 
-inline rs_config RS_CONFIG;
\ No newline at end of file
+// config of the compilation running on this thread, see rs_context in context.hpp.
+rs_config& currentConfig();
+#define RS_CONFIG currentConfig()
\ No newline at end of file
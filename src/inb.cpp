@@ -2,6 +2,7 @@
 #include "rbc.hpp"
 #include "lang.hpp"
 #include "mchelpers.hpp"
+#include "util.hpp"
 
 // for readability
 #ifndef INB_IMPL_PARAMETERS
@@ -29,31 +30,56 @@ namespace inb_impls
         if (_const.val_type != token_type::SELECTOR_LITERAL)
             goto fail;
 
-        rbc_value& val = parameters.at(1);
-        switch(val.index())
+        // every argument after the selector is one component of the same tellraw, values are read where they are.
+        std::vector<std::string> components;
+        for (size_t i = 1; i < parameters.size(); i++)
         {
-            case 0:
+            rbc_value& val = parameters.at(i);
+            switch(val.index())
             {
-                rbc_constant& c = std::get<0>(val);
-                
-                factory.create_and_push(MC_TELLRAW_CMD_ID, MC_TELLRAW_CONST(_const.val, c.val));
-                break;
+                case 0:
+                {
+                    rbc_constant& c = std::get<0>(val);
+                    if (c.val_type == token_type::SELECTOR_LITERAL)
+                        components.push_back(MC_TELLRAW_SELECTOR(util::jsonString('@' + c.val)));
+                    else if (c.val_type == token_type::STRING_LITERAL)
+                        components.push_back(util::jsonString(util::unescape(c.val)));
+                    else // numbers are quoted too, a bare 4 is not a component in an array.
+                        components.push_back(util::jsonString(c.val));
+                    break;
+                }
+                case 1:
+                {
+                    rbc_register& reg = *std::get<1>(val);
+                    if (reg.operable)
+                        components.push_back(MC_TELLRAW_SCORE(reg.id));
+                    else
+                        components.push_back(MC_TELLRAW_NBT(ARR_AT(RS_PROGRAM_REGISTERS, STR(reg.id))));
+                    break;
+                }
+                case 2:
+                {
+                    rs_variable& var = *std::get<2>(val);
+                    components.push_back(MC_TELLRAW_NBT(MC_VARIABLE_VALUE(var.comp_info.varIndex)));
+                    break;
+                }
+                default:
+                    IMPL_ERROR("tellraw does not accept these parameter types in this version.");
             }
-            case 1:
-            {
-                WARN("Non implemented tellraw functionality.");
-                break;
-            }
-            case 2:
-            {
-                rs_variable& var = *std::get<2>(val);
-                factory.create_and_push(MC_TELLRAW_CMD_ID, MC_TELLRAW_VARIABLE(_const.val, var.comp_info.varIndex));
-                break;
-            }
-            default:
-                IMPL_ERROR("tellraw does not accept these parameter types in this version.");
         }
-        
+        if (components.empty())
+            IMPL_ERROR("Expected a message after the selector for candidate (tellraw) impl::msg.");
+
+        // a lone constant is its own text component.
+        if (components.size() == 1 && parameters.at(1).index() == 0)
+        {
+            factory.create_and_push(MC_TELLRAW_CMD_ID, MC_TELLRAW_CONST(_const.val, components.front()));
+            return;
+        }
+        std::string message = "[";
+        for (size_t i = 0; i < components.size(); i++)
+            message += (i ? ", " : "") + components.at(i);
+        factory.create_and_push(MC_TELLRAW_CMD_ID, MC_TELLRAW_CONST(_const.val, message + ']'));
     }
     void kill(INB_IMPL_PARAMETERS)
     {
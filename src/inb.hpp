@@ -1,5 +1,6 @@
 #pragma once
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <variant>
 #include <memory>
@@ -27,9 +28,11 @@ namespace inb_impls
     void msg(INB_IMPL_PARAMETERS);
     void kill(INB_IMPL_PARAMETERS);
 
-    inline std::unordered_map<std::string, void(*)(INB_IMPL_PARAMETERS)> INB_IMPLS_MAP = 
+    inline const std::unordered_map<std::string, void(*)(INB_IMPL_PARAMETERS)> INB_IMPLS_MAP = 
     {
         {"msg", msg},
         {"kill", kill}
     };
+    // inbuilts that take any number of arguments after their declared parameters.
+    inline const std::unordered_set<std::string> INB_VARIADIC = {"msg"};
 }
\ No newline at end of file
@@ -0,0 +1,828 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include "interp.hpp"
+#include "lang.hpp"
+#include "util.hpp"
+
+namespace interp
+{
+    static const size_t npos = static_cast<size_t>(-1);
+
+    struct interpreter::frame
+    {
+        std::string function;
+        size_t at = 0;
+        // the globals for the global function, own otherwise.
+        std::unordered_map<const rs_variable*, sim::nbt>* locals = nullptr;
+        std::unordered_map<const rs_variable*, sim::nbt> own;
+        // arguments pushed for the next call, in push order.
+        std::vector<std::pair<const rs_variable*, sim::nbt>> pushed;
+        struct loop
+        {
+            size_t head, end;
+            // the keys a map loop has yet to run for.
+            std::vector<sim::nbt> keys = {};
+        };
+        std::vector<loop> loops;
+    };
+
+    // the name tomc gives the function as its source, which pgo profiles are keyed by.
+    static std::string sourceName(const rbc_function& function)
+    {
+        std::string name = function.name;
+        for (auto parent = function.parent; parent; parent = parent->parent)
+            name = parent->name + '.' + name;
+        for (auto _module = function.modulePath.rbegin(); _module != function.modulePath.rend(); ++_module)
+            name = *_module + "::" + name;
+        return name;
+    }
+    static bool has(const rbc_function& function, rbc_function_decorator decorator)
+    {
+        return std::find(function.decorators.begin(), function.decorators.end(), decorator) != function.decorators.end();
+    }
+    // {keys:[], values:{}}, what tomc stores a map as.
+    static sim::nbt emptyMap()
+    {
+        sim::nbt keys, values;
+        keys.type = sim::nbt_type::LIST;
+        sim::nbt map;
+        map.compound = {{"keys", keys}, {"values", values}};
+        return map;
+    }
+
+    interpreter::interpreter(rbc_program& program, const options& opts) : _program(program), _options(opts)
+    {
+        auto selector = [](const sim::nbt& argument) { return argument.type == sim::nbt_type::STRING ? argument.text : argument.str(); };
+        inbuilts["msg"] = [selector](interpreter& self, const std::vector<sim::nbt>& arguments, std::string& err)
+        {
+            if (arguments.size() < 2)
+                return err = "msg takes a selector and a message.", false;
+            std::string message;
+            for (size_t i = 1; i < arguments.size(); i++)
+                message += selector(arguments[i]);
+            self.output.push_back(message);
+            return true;
+        };
+        inbuilts["kill"] = [selector](interpreter& self, const std::vector<sim::nbt>& arguments, std::string& err)
+        {
+            if (arguments.size() != 1)
+                return err = "kill takes a selector.", false;
+            self.output.push_back("kill " + selector(arguments[0]));
+            return true;
+        };
+    }
+
+    run_result interpreter::run()
+    {
+        run_result result;
+        _run   = &result;
+        _depth = 0;
+        frame global;
+        global.function = RS_GLOBAL_SOURCE_NAME;
+        global.locals   = &_globals;
+        outcome done = execute(_program.globalFunction.instructions, global.function, global);
+        result.ok       = done.ok;
+        result.returned = done.returned && !result.truncated;
+        result.value    = done.value;
+        _run = nullptr;
+        return result;
+    }
+    run_result interpreter::call(const std::string& function, const std::unordered_map<std::string, sim::nbt>& arguments)
+    {
+        run_result result;
+        _run   = &result;
+        _depth = 0;
+        frame callee;
+        callee.function = function;
+        callee.locals   = &callee.own;
+        std::shared_ptr<rbc_function> found = find(function);
+        outcome done{false, false, {}};
+        if (!found)
+            fail(callee, "Unknown function.");
+        else
+        {
+            callee.function = sourceName(*found);
+            for (auto& [name, value] : arguments)
+            {
+                rs_variable* parameter = found->getParameterByName(name);
+                if (!parameter)
+                {
+                    fail(callee, "No parameter named '" + name + "'.");
+                    break;
+                }
+                callee.own[parameter] = value;
+            }
+            if (result.error.empty())
+                done = execute(found->instructions, callee.function, callee);
+        }
+        result.ok       = done.ok && result.error.empty();
+        result.returned = done.returned && !result.truncated;
+        result.value    = done.value;
+        _run = nullptr;
+        return result;
+    }
+    const sim::nbt* interpreter::global(const std::string& name) const
+    {
+        for (auto& [var, value] : _globals)
+            if (var->name == name)
+                return &value;
+        return nullptr;
+    }
+
+    interpreter::outcome interpreter::fail(frame& at, const std::string& message)
+    {
+        if (_run && _run->error.empty())
+            _run->error = at.function + ':' + std::to_string(at.at + 1) + ": " + message;
+        return outcome{false, false, {}};
+    }
+
+    const std::vector<interpreter::jumps>& interpreter::jumpsOf(std::vector<rbc_command>& body)
+    {
+        auto cached = _jumps.find(&body);
+        if (cached != _jumps.end() && cached->second.size() == body.size())
+            return cached->second;
+
+        std::vector<jumps> out(body.size());
+        std::vector<std::vector<size_t>> chains;
+        std::vector<std::pair<size_t, size_t>> loops; // head, while
+        for (size_t i = 0; i < body.size(); i++)
+        {
+            switch (body[i].type)
+            {
+                case rbc_instruction::IF:
+                case rbc_instruction::NIF:
+                    chains.push_back({i});
+                    break;
+                case rbc_instruction::ELIF:
+                case rbc_instruction::NELIF:
+                case rbc_instruction::ELSE:
+                    if (chains.empty())
+                        break;
+                    out[chains.back().back()].next = i;
+                    chains.back().push_back(i);
+                    break;
+                case rbc_instruction::ENDIF:
+                    if (chains.empty())
+                        break;
+                    out[chains.back().back()].next = i;
+                    for (size_t member : chains.back())
+                        out[member].end = i;
+                    chains.pop_back();
+                    break;
+                case rbc_instruction::LOOP:
+                case rbc_instruction::FOR:
+                    loops.push_back({i, npos});
+                    break;
+                case rbc_instruction::WHILE:
+                    if (!loops.empty() && loops.back().second == npos)
+                        loops.back().second = i;
+                    break;
+                case rbc_instruction::ENDLOOP:
+                    if (loops.empty())
+                        break;
+                    out[loops.back().first].end = i;
+                    if (loops.back().second != npos)
+                        out[loops.back().second].end = i;
+                    out[i].next = loops.back().first;
+                    loops.pop_back();
+                    break;
+                default:
+                    break;
+            }
+        }
+        return _jumps[&body] = std::move(out);
+    }
+
+    std::shared_ptr<rbc_function> interpreter::find(const rbc_command& instruction, size_t nameAt, size_t moduleAt)
+    {
+        rbc_value& name = *instruction.parameters.at(nameAt);
+        if (name.index() == 5)
+            return std::static_pointer_cast<rbc_function>(std::get<5>(name));
+        const std::string& fname = std::get<rbc_constant>(name).val;
+        if (instruction.parameters.size() > moduleAt && instruction.parameters.at(moduleAt)->index() == 5)
+        {
+            rs_module* from = static_cast<rs_module*>(std::get<5>(*instruction.parameters.at(moduleAt)).get());
+            if (!from)
+                return nullptr;
+            auto found = from->functions.find(fname);
+            return found == from->functions.end() ? nullptr : found->second;
+        }
+        auto found = _program.functions.find(fname);
+        return found == _program.functions.end() ? nullptr : found->second;
+    }
+    std::shared_ptr<rbc_function> interpreter::find(const std::string& path)
+    {
+        std::vector<std::string> parts;
+        for (size_t start = 0, end; start <= path.size(); start = end + 2)
+        {
+            end = path.find("::", start);
+            if (end == std::string::npos)
+                end = path.size();
+            parts.push_back(path.substr(start, end - start));
+        }
+        if (parts.size() == 1)
+        {
+            auto found = _program.functions.find(parts[0]);
+            return found == _program.functions.end() ? nullptr : found->second;
+        }
+        auto _module = _program.modules.find(parts[0]);
+        if (_module == _program.modules.end())
+            return nullptr;
+        std::shared_ptr<rs_module> at = _module->second;
+        for (size_t i = 1; i + 1 < parts.size(); i++)
+        {
+            auto child = at->children.find(parts[i]);
+            if (child == at->children.end())
+                return nullptr;
+            at = child->second;
+        }
+        auto found = at->functions.find(parts.back());
+        return found == at->functions.end() ? nullptr : found->second;
+    }
+
+    sim::nbt* interpreter::variable(const rs_variable* var, frame& at)
+    {
+        auto local = at.locals->find(var);
+        if (local != at.locals->end())
+            return &local->second;
+        auto global = _globals.find(var);
+        return global == _globals.end() ? nullptr : &global->second;
+    }
+    bool interpreter::read(rbc_value& value, frame& at, sim::nbt& out)
+    {
+        switch (value.index())
+        {
+            case 0:
+            {
+                rbc_constant& c = std::get<0>(value);
+                switch (c.val_type)
+                {
+                    case token_type::INT_LITERAL:
+                        out = sim::nbt::ofInt(std::stoll(c.val));
+                        return true;
+                    case token_type::FLOAT_LITERAL:
+                        out = sim::nbt::ofInt(0, sim::nbt_type::DOUBLE);
+                        out.real = std::stod(c.val);
+                        return true;
+                    case token_type::SELECTOR_LITERAL:
+                        out = sim::nbt::ofString('@' + c.val);
+                        return true;
+                    case token_type::STRING_LITERAL: // the source escapes, read like snbt reads them.
+                        out = sim::nbt::ofString(util::unescape(c.val));
+                        return true;
+                    default:
+                        out = sim::nbt::ofString(c.val);
+                        return true;
+                }
+            }
+            case 1:
+            {
+                auto reg = _registers.find(std::get<1>(value)->id);
+                // an unset score reads as 0, like a failed 'scoreboard players get'.
+                out = reg == _registers.end() ? sim::nbt::ofInt(0) : reg->second;
+                return true;
+            }
+            case 2:
+            {
+                const rs_variable& var = *std::get<2>(value);
+                sim::nbt* found = variable(&var, at);
+                if (!found)
+                    return fail(at, "Variable '" + var.name + "' read before it was created."), false;
+                out = *found;
+                return true;
+            }
+            case 4:
+            {
+                out = sim::nbt{};
+                out.type = sim::nbt_type::LIST;
+                for (auto& element : std::get<4>(value)->values)
+                {
+                    sim::nbt e;
+                    if (!read(*element, at, e))
+                        return false;
+                    out.list.push_back(std::move(e));
+                }
+                return true;
+            }
+            default:
+                return fail(at, "Objects are not supported by the interpreter yet."), false;
+        }
+    }
+    bool interpreter::test(rbc_command& instruction, frame& at, bool& holds)
+    {
+        const bool invert = instruction.type == rbc_instruction::NIF || instruction.type == rbc_instruction::NELIF;
+        if (instruction.parameters.size() == 1)
+        {
+            sim::nbt value;
+            if (!read(*instruction.parameters.at(0), at, value))
+                return false;
+            holds = value.numeric() ? value.number() != 0 : value.type != sim::nbt_type::STRING || !value.text.empty();
+        }
+        else if (instruction.parameters.size() == 3)
+        {
+            sim::nbt lhs, rhs;
+            if (!read(*instruction.parameters.at(0), at, lhs) || !read(*instruction.parameters.at(2), at, rhs))
+                return false;
+            holds = (lhs == rhs) == (std::get<0>(*instruction.parameters.at(1)).val == "==");
+        }
+        else
+            return fail(at, "Malformed condition."), false;
+        holds ^= invert;
+        return true;
+    }
+    // scoreboard arithmetic for ints: 32 bit, wrapping, flooring division and modulo, x / 0 leaves x as is.
+    bool interpreter::math(sim::nbt& lhs, const sim::nbt& rhs, int operation, std::string& err)
+    {
+        if (!lhs.numeric() || !rhs.numeric())
+            return err = "Math on " + lhs.str() + " and " + rhs.str() + " is not supported.", false;
+        const bool real = lhs.type == sim::nbt_type::FLOAT || lhs.type == sim::nbt_type::DOUBLE ||
+                          rhs.type == sim::nbt_type::FLOAT || rhs.type == sim::nbt_type::DOUBLE;
+        if (real)
+        {
+            double a = lhs.number(), b = rhs.number();
+            switch (operation)
+            {
+                case 0: a += b; break;
+                case 1: a -= b; break;
+                case 2: a *= b; break;
+                case 3: a /= b; break;
+                case 4: a = std::fmod(a, b); break;
+                case 6: a = std::pow(a, b); break;
+                default: return err = "Operation " + std::to_string(operation) + " is not supported on decimals.", false;
+            }
+            lhs = sim::nbt::ofInt(0, sim::nbt_type::DOUBLE);
+            lhs.real = a;
+            return true;
+        }
+        const uint32_t a = static_cast<uint32_t>(lhs.integer), b = static_cast<uint32_t>(rhs.integer);
+        const int32_t sa = static_cast<int32_t>(a), sb = static_cast<int32_t>(b);
+        int32_t result = sa;
+        switch (operation)
+        {
+            case 0: result = static_cast<int32_t>(a + b); break;
+            case 1: result = static_cast<int32_t>(a - b); break;
+            case 2: result = static_cast<int32_t>(a * b); break;
+            case 3: if (sb) result = static_cast<int32_t>(std::floor(static_cast<double>(sa) / sb)); break;
+            case 4: if (sb) result = ((sa % sb) + sb) % sb; break;
+            case 5: result = static_cast<int32_t>(a ^ b); break;
+            case 6:
+            {
+                uint32_t power = 1;
+                for (int32_t i = 0; i < sb; i++)
+                    power *= a;
+                result = static_cast<int32_t>(power);
+                break;
+            }
+            default: return err = "Unknown operation " + std::to_string(operation) + '.', false;
+        }
+        lhs = sim::nbt::ofInt(result);
+        return true;
+    }
+
+    interpreter::outcome interpreter::execute(std::vector<rbc_command>& body, const std::string& name, frame& at)
+    {
+        if (++_depth > _options.maxDepth)
+        {
+            _depth--;
+            return fail(at, "Calls nested deeper than " + std::to_string(_options.maxDepth) + '.');
+        }
+        const std::vector<jumps>& jump = jumpsOf(body);
+        size_t& self = instructions[name];
+        outcome result;
+        std::string err;
+
+        #define INTERP_FAIL(message) { result = fail(at, message); break; }
+        // read and test have already set the error, this only unwinds.
+        #define INTERP_UNWIND { result = outcome{false, false, {}}; break; }
+        for (size_t& pc = at.at; pc < body.size(); pc++)
+        {
+            if (_run->instructions >= _options.maxInstructions)
+            {
+                _run->truncated = true;
+                result = outcome{true, true, {}};
+                break;
+            }
+            _run->instructions++;
+            self++;
+
+            rbc_command& instruction = body[pc];
+            auto parameter = [&](size_t p) -> rbc_value& { return *instruction.parameters.at(p); };
+            switch (instruction.type)
+            {
+                case rbc_instruction::CREATE:
+                {
+                    const rs_variable* var = std::get<2>(parameter(0)).get();
+                    sim::nbt value = var->type_info.isMap() ? emptyMap() : sim::nbt::ofInt(0);
+                    if (instruction.parameters.size() > 1 && !read(parameter(1), at, value))
+                        INTERP_UNWIND;
+                    (*at.locals)[var] = value;
+                    continue;
+                }
+                case rbc_instruction::SAVE:
+                {
+                    sim::nbt value;
+                    if (!read(parameter(1), at, value))
+                        INTERP_UNWIND;
+                    if (parameter(0).index() == 1)
+                    {
+                        _registers[std::get<1>(parameter(0))->id] = value;
+                        continue;
+                    }
+                    const rs_variable* var = std::get<2>(parameter(0)).get();
+                    sim::nbt* target = variable(var, at);
+                    if (!target)
+                        INTERP_FAIL("Variable '" + var->name + "' set before it was created.");
+                    *target = value;
+                    continue;
+                }
+                case rbc_instruction::MATH:
+                {
+                    // the register is the result, whichever side it is on.
+                    const int operation = std::stoi(std::get<0>(parameter(2)).val);
+                    const bool left = parameter(0).index() == 1;
+                    if (!left && parameter(1).index() != 1)
+                        INTERP_FAIL("Math without a register.");
+                    sim::nbt& reg = _registers.try_emplace(std::get<1>(parameter(left ? 0 : 1))->id, sim::nbt::ofInt(0)).first->second;
+                    sim::nbt other;
+                    if (!read(parameter(left ? 1 : 0), at, other))
+                        INTERP_UNWIND;
+                    if (!math(reg, other, operation, err))
+                        INTERP_FAIL(err);
+                    continue;
+                }
+                case rbc_instruction::IF:
+                case rbc_instruction::NIF:
+                {
+                    bool holds;
+                    if (!test(instruction, at, holds))
+                        INTERP_UNWIND;
+                    if (holds)
+                        continue;
+                    // the first ELIF that holds, else the ELSE or ENDIF.
+                    for (size_t next = jump[pc].next;; next = jump[next].next)
+                    {
+                        if (next == npos)
+                        {
+                            result = fail(at, "Unterminated if.");
+                            break;
+                        }
+                        rbc_command& branch = body[next];
+                        if (branch.type != rbc_instruction::ELIF && branch.type != rbc_instruction::NELIF)
+                        {
+                            pc = next;
+                            break;
+                        }
+                        _run->instructions++;
+                        self++;
+                        pc = next;
+                        if (!test(branch, at, holds))
+                        {
+                            result = outcome{false, false, {}};
+                            break;
+                        }
+                        if (holds)
+                            break;
+                    }
+                    if (!result.ok)
+                        break;
+                    continue;
+                }
+                case rbc_instruction::ELIF:
+                case rbc_instruction::NELIF:
+                case rbc_instruction::ELSE:
+                    // the branch before ran, skip the rest of the chain.
+                    if (jump[pc].end == npos)
+                        INTERP_FAIL("Unterminated if.");
+                    pc = jump[pc].end;
+                    continue;
+                case rbc_instruction::LOOP:
+                    if (jump[pc].end == npos)
+                        INTERP_FAIL("Unterminated loop.");
+                    at.loops.push_back({pc, jump[pc].end});
+                    continue;
+                case rbc_instruction::WHILE:
+                {
+                    bool holds;
+                    if (!test(instruction, at, holds))
+                        INTERP_UNWIND;
+                    if (!holds)
+                    {
+                        pc = at.loops.back().end;
+                        at.loops.pop_back();
+                    }
+                    continue;
+                }
+                case rbc_instruction::FOR:
+                {
+                    if (jump[pc].end == npos)
+                        INTERP_FAIL("Unterminated loop.");
+                    // there are no entities, an entity loop runs its body once like 'execute as' does in sim::machine.
+                    if (instruction.parameters.size() == 1)
+                    {
+                        at.loops.push_back({pc, jump[pc].end});
+                        continue;
+                    }
+                    if (instruction.parameters.size() == 2)
+                    {
+                        const rs_variable* var = std::get<2>(parameter(1)).get();
+                        sim::nbt* map = variable(var, at);
+                        sim::nbt* keys = map ? map->member("keys") : nullptr;
+                        if (!keys)
+                            INTERP_FAIL("Map '" + var->name + "' used before it was created.");
+                        sim::nbt* key = variable(std::get<2>(parameter(0)).get(), at);
+                        if (keys->list.empty() || !key)
+                        {
+                            pc = jump[pc].end;
+                            continue;
+                        }
+                        *key = *keys->list.front().member("k");
+                        at.loops.push_back({pc, jump[pc].end, std::vector<sim::nbt>(keys->list.begin() + 1, keys->list.end())});
+                        continue;
+                    }
+                    sim::nbt from, to;
+                    if (!read(parameter(1), at, from) || !read(parameter(2), at, to))
+                        INTERP_UNWIND;
+                    const rs_variable* counter = std::get<2>(parameter(0)).get();
+                    sim::nbt* value = variable(counter, at);
+                    if (!value)
+                        value = &((*at.locals)[counter]);
+                    *value = from;
+                    if (value->number() < to.number())
+                        at.loops.push_back({pc, jump[pc].end});
+                    else
+                        pc = jump[pc].end;
+                    continue;
+                }
+                case rbc_instruction::ENDLOOP:
+                {
+                    if (at.loops.empty())
+                        INTERP_FAIL("End of a loop that was not entered.");
+                    const size_t head = at.loops.back().head;
+                    rbc_command& loop = body[head];
+                    if (loop.type == rbc_instruction::LOOP)
+                    {
+                        pc = head;
+                        continue;
+                    }
+                    if (loop.parameters.size() == 1)
+                    {
+                        at.loops.pop_back();
+                        continue;
+                    }
+                    if (loop.parameters.size() == 2)
+                    {
+                        std::vector<sim::nbt>& keys = at.loops.back().keys;
+                        sim::nbt* key = variable(std::get<2>(*loop.parameters.at(0)).get(), at);
+                        if (keys.empty() || !key)
+                        {
+                            at.loops.pop_back();
+                            continue;
+                        }
+                        *key = *keys.front().member("k");
+                        keys.erase(keys.begin());
+                        pc = head;
+                        continue;
+                    }
+                    sim::nbt to;
+                    sim::nbt* counter = variable(std::get<2>(*loop.parameters.at(0)).get(), at);
+                    if (!counter || !read(*loop.parameters.at(2), at, to))
+                        INTERP_FAIL("Loop counter went missing.");
+                    *counter = sim::nbt::ofInt(counter->integer + 1);
+                    if (counter->number() < to.number())
+                        pc = head;
+                    else
+                        at.loops.pop_back();
+                    continue;
+                }
+                case rbc_instruction::BREAK:
+                    if (at.loops.empty())
+                        INTERP_FAIL("Break outside of a loop.");
+                    pc = at.loops.back().end;
+                    at.loops.pop_back();
+                    continue;
+                case rbc_instruction::CONTINUE:
+                    if (at.loops.empty())
+                        INTERP_FAIL("Continue outside of a loop.");
+                    // runs the ENDLOOP next, which starts the next iteration.
+                    pc = at.loops.back().end - 1;
+                    continue;
+                case rbc_instruction::PUSH:
+                {
+                    std::shared_ptr<rbc_function> function = find(instruction, 0, 3);
+                    const std::string& parameterName = std::get<0>(parameter(1)).val;
+                    rs_variable* param = function ? function->getParameterByName(parameterName) : nullptr;
+                    if (!param)
+                        INTERP_FAIL("Unknown parameter '" + parameterName + "'.");
+                    sim::nbt value;
+                    if (!read(parameter(2), at, value))
+                        INTERP_UNWIND;
+                    at.pushed.push_back({param, std::move(value)});
+                    continue;
+                }
+                case rbc_instruction::CALL:
+                {
+                    std::shared_ptr<rbc_function> function = find(instruction, 0, 1);
+                    if (!function)
+                        INTERP_FAIL("Unknown function.");
+                    std::vector<std::pair<const rs_variable*, sim::nbt>> arguments;
+                    arguments.swap(at.pushed);
+                    if (has(*function, rbc_function_decorator::CPP))
+                    {
+                        auto stub = inbuilts.find(function->name);
+                        if (stub == inbuilts.end())
+                            INTERP_FAIL("No stub for inbuilt '" + function->name + "'.");
+                        std::vector<sim::nbt> values;
+                        for (auto& argument : arguments)
+                            values.push_back(std::move(argument.second));
+                        if (!stub->second(*this, values, err))
+                            INTERP_FAIL(function->name + ": " + err);
+                        continue;
+                    }
+                    frame callee;
+                    callee.function = sourceName(*function);
+                    callee.locals   = &callee.own;
+                    for (auto& [param, value] : arguments)
+                        callee.own[param] = std::move(value);
+                    outcome called = execute(function->instructions, callee.function, callee);
+                    if (!called.ok)
+                    {
+                        result = called;
+                        break;
+                    }
+                    if (_run->truncated)
+                    {
+                        result = outcome{true, true, {}};
+                        break;
+                    }
+                    if (called.returned)
+                        _returned = called.value;
+                    continue;
+                }
+                case rbc_instruction::SAVERET:
+                {
+                    const rs_variable* var = std::get<2>(parameter(0)).get();
+                    sim::nbt* target = variable(var, at);
+                    if (!target)
+                        target = &((*at.locals)[var]);
+                    *target = _returned;
+                    continue;
+                }
+                case rbc_instruction::CAST:
+                {
+                    const rs_object& type = *std::get<3>(parameter(1));
+                    sim::nbt source = _returned;
+                    if (instruction.parameters.size() == 3 && !read(parameter(2), at, source))
+                        INTERP_UNWIND;
+                    // the same steps castObject lowers to: the defaults, the members the source has, then the
+                    // required check.
+                    std::map<std::string, const rs_object::_MemberT*> members;
+                    for (auto& [name, member] : type.members)
+                        members.insert({name, &member});
+                    sim::nbt cast;
+                    for (auto& [name, member] : members)
+                    {
+                        sim::nbt value;
+                        std::string err;
+                        if (member->second != rs_object_member_decorator::REQUIRED && sim::parse(memberDefault(*member), value, err))
+                            cast.compound.push_back({name, value});
+                    }
+                    for (auto& [name, member] : members)
+                    {
+                        sim::nbt* found = source.type == sim::nbt_type::COMPOUND ? source.member(name) : nullptr;
+                        if (!found || member->second == rs_object_member_decorator::SEPERATE)
+                            continue;
+                        if (sim::nbt* kept = cast.member(name))
+                            *kept = *found;
+                        else
+                            cast.compound.push_back({name, *found});
+                    }
+                    for (auto& [name, member] : members)
+                        if (member->second == rs_object_member_decorator::REQUIRED && (source.type != sim::nbt_type::COMPOUND || !source.member(name)))
+                            cast = sim::nbt::ofInt(0);
+
+                    const rs_variable* var = std::get<2>(parameter(0)).get();
+                    sim::nbt* target = variable(var, at);
+                    if (!target)
+                        INTERP_FAIL("Variable '" + var->name + "' set before it was created.");
+                    *target = cast;
+                    continue;
+                }
+                case rbc_instruction::INDEX:
+                case rbc_instruction::SETINDEX:
+                {
+                    const bool write = instruction.type == rbc_instruction::SETINDEX;
+                    const rs_variable* var = std::get<2>(parameter(write ? 0 : 1)).get();
+                    sim::nbt* list = variable(var, at);
+                    if (!list)
+                        INTERP_FAIL("Variable '" + var->name + "' used before it was created.");
+                    sim::nbt index;
+                    if (!read(parameter(write ? 1 : 2), at, index))
+                        INTERP_UNWIND;
+                    if (var->type_info.isMap())
+                    {
+                        // a missing key leaves the variable as it was, setting one adds it to the keys.
+                        sim::nbt* values = list->member("values");
+                        sim::nbt* keys   = list->member("keys");
+                        if (!values || !keys)
+                            INTERP_FAIL("'" + var->name + "' is not a map.");
+                        sim::nbt* entry = values->member(index.text);
+                        if (write)
+                        {
+                            sim::nbt value;
+                            if (!read(parameter(2), at, value))
+                                INTERP_UNWIND;
+                            if (entry)
+                            {
+                                *entry = value;
+                                continue;
+                            }
+                            sim::nbt key;
+                            key.compound = {{"k", index}};
+                            keys->list.push_back(key);
+                            values->compound.push_back({index.text, value});
+                            continue;
+                        }
+                        if (!entry)
+                            continue;
+                        const rs_variable* into = std::get<2>(parameter(0)).get();
+                        sim::nbt* target = variable(into, at);
+                        if (!target)
+                            INTERP_FAIL("Variable '" + into->name + "' set before it was created.");
+                        *target = *entry;
+                        continue;
+                    }
+                    if (list->type != sim::nbt_type::LIST)
+                        INTERP_FAIL("'" + var->name + "' is not a list.");
+                    // like an nbt path, a negative index counts from the end and one out of range changes nothing.
+                    long long i = static_cast<long long>(index.number());
+                    const long long size = list->list.size();
+                    if (i < 0)
+                        i += size;
+                    if (i < 0 || i >= size)
+                        continue;
+                    if (write)
+                    {
+                        if (!read(parameter(2), at, list->list.at(i)))
+                            INTERP_UNWIND;
+                        continue;
+                    }
+                    const rs_variable* into = std::get<2>(parameter(0)).get();
+                    sim::nbt* target = variable(into, at);
+                    if (!target)
+                        INTERP_FAIL("Variable '" + into->name + "' set before it was created.");
+                    *target = list->list.at(i);
+                    continue;
+                }
+                case rbc_instruction::HASKEY:
+                case rbc_instruction::DELKEY:
+                {
+                    const bool remove = instruction.type == rbc_instruction::DELKEY;
+                    const rs_variable* var = std::get<2>(parameter(remove ? 0 : 1)).get();
+                    sim::nbt* map = variable(var, at);
+                    if (!map)
+                        INTERP_FAIL("Variable '" + var->name + "' used before it was created.");
+                    if (remove && instruction.parameters.size() == 1)
+                    {
+                        *map = emptyMap();
+                        continue;
+                    }
+                    sim::nbt* values = map->member("values");
+                    sim::nbt* keys   = map->member("keys");
+                    if (!values || !keys)
+                        INTERP_FAIL("'" + var->name + "' is not a map.");
+                    sim::nbt key;
+                    if (!read(parameter(remove ? 1 : 2), at, key))
+                        INTERP_UNWIND;
+                    if (!remove)
+                    {
+                        const rs_variable* into = std::get<2>(parameter(0)).get();
+                        sim::nbt* target = variable(into, at);
+                        if (!target)
+                            INTERP_FAIL("Variable '" + into->name + "' set before it was created.");
+                        *target = sim::nbt::ofInt(values->member(key.text) ? 1 : 0);
+                        continue;
+                    }
+                    std::erase_if(values->compound, [&](const auto& m) { return m.first == key.text; });
+                    std::erase_if(keys->list, [&](sim::nbt& k) { sim::nbt* at = k.member("k"); return at && at->text == key.text; });
+                    continue;
+                }
+                case rbc_instruction::RET:
+                {
+                    result = outcome{true, true, sim::nbt::ofInt(0)};
+                    if (!instruction.parameters.empty() && !read(parameter(0), at, result.value))
+                        INTERP_UNWIND;
+                    break;
+                }
+                default:
+                    // ENDIF, POP, INC, DEC, DEL, and YIELD, which runs the rest of the function right away.
+                    continue;
+            }
+            break;
+        }
+        #undef INTERP_FAIL
+        #undef INTERP_UNWIND
+        _depth--;
+        return result;
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "rbc.hpp"
+#include "sim.hpp"
+
+// runs rbc programs directly, without lowering them to commands. values are sim::nbt, so results can be
+// compared with what sim::machine computes for the same program once tomc compiled it.
+//
+// the interpreter reads the program as torbc left it. tomc rewrites instructions and constants in place,
+// so interpret a program before converting it, not after.
+namespace interp
+{
+    struct options
+    {
+        // a run stops after this many instructions.
+        size_t maxInstructions = 1 << 24;
+        size_t maxDepth        = 1024;
+    };
+    struct run_result
+    {
+        bool ok = true;
+        // '<function>:<instruction>: <message>' for the instruction that could not be run.
+        std::string error = "";
+        size_t instructions = 0;
+        bool truncated = false;
+        bool returned  = false;
+        sim::nbt value;
+    };
+
+    class interpreter;
+    // stands in for a __cpp__ function. arguments are in call order. returns false and sets err to stop the run.
+    using inbuilt = std::function<bool(interpreter&, const std::vector<sim::nbt>& arguments, std::string& err)>;
+
+    class interpreter
+    {
+    public:
+        explicit interpreter(rbc_program& program, const options& opts = {});
+
+        // runs the global function.
+        run_result run();
+        // runs one function, 'name' or 'module::name', with arguments by parameter name.
+        run_result call(const std::string& function, const std::unordered_map<std::string, sim::nbt>& arguments);
+
+        // the value of a global variable, nullptr before it is created.
+        const sim::nbt* global(const std::string& name) const;
+
+        // what the inbuilt stubs printed. msg and kill write what tellraw and kill write in sim::machine.
+        std::vector<std::string> output;
+        // instructions run in each function itself, keyed like pgo profiles ('<global>', 'module::name').
+        std::unordered_map<std::string, size_t> instructions;
+        std::unordered_map<std::string, inbuilt> inbuilts;
+
+    private:
+        // where control goes from an instruction. for IF, ELIF and ELSE, next is the following ELIF, ELSE or
+        // ENDIF of the chain and end its ENDIF. for LOOP, FOR and WHILE, end is the ENDLOOP, and for ENDLOOP
+        // next is the head of its loop.
+        struct jumps
+        {
+            size_t next = static_cast<size_t>(-1);
+            size_t end  = static_cast<size_t>(-1);
+        };
+        struct frame;
+        struct outcome
+        {
+            bool ok = true;
+            bool returned = false;
+            sim::nbt value;
+        };
+
+        rbc_program& _program;
+        options _options;
+        std::unordered_map<uint, sim::nbt> _registers;
+        std::unordered_map<const rs_variable*, sim::nbt> _globals;
+        std::unordered_map<const std::vector<rbc_command>*, std::vector<jumps>> _jumps;
+        sim::nbt _returned;
+        run_result* _run = nullptr;
+        size_t _depth    = 0;
+
+        outcome execute(std::vector<rbc_command>& body, const std::string& name, frame& at);
+        const std::vector<jumps>& jumpsOf(std::vector<rbc_command>& body);
+        std::shared_ptr<rbc_function> find(const rbc_command& instruction, size_t nameAt, size_t moduleAt);
+        std::shared_ptr<rbc_function> find(const std::string& path);
+
+        bool read(rbc_value& value, frame& at, sim::nbt& out);
+        sim::nbt* variable(const rs_variable* var, frame& at);
+        bool test(rbc_command& instruction, frame& at, bool& holds);
+        bool math(sim::nbt& lhs, const sim::nbt& rhs, int operation, std::string& err);
+        outcome fail(frame& at, const std::string& message);
+    };
+}
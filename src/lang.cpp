@@ -64,6 +64,29 @@ std::shared_ptr<rs_object> parseInlineObject(rbc_program& program, token_list& t
     return std::make_shared<rs_object>(obj);
     
 }
+std::string memberDefault(const rs_object::_MemberT& member)
+{
+    const rs_variable& var = member.first;
+    if (!var.value)
+    {
+        if (member.second != rs_object_member_decorator::SEPERATE)
+            return "";
+        return var.type_info.type_id == RS_STRING_KW_ID ? "\"\"" : var.type_info.type_id == RS_FLOAT_KW_ID ? "0.0" : "0";
+    }
+    if (!var.value->operation.isSingular())
+        return "";
+    const token& value = std::get<token>(*var.value->operation.left);
+    switch (value.type)
+    {
+        case token_type::INT_LITERAL:
+        case token_type::FLOAT_LITERAL:
+            return value.repr;
+        case token_type::STRING_LITERAL:
+            return '"' + value.repr + '"';
+        default:
+            return "";
+    }
+}
 
 #pragma endregion objects
 #pragma region expressions
@@ -415,6 +438,12 @@ std::shared_ptr<rs_list> parseList(rbc_program& program, token_list& tlist, size
     const size_t S = tlist.size();
     // just for error
     token& at = tlist.at(start);
+    // []
+    if (at.type == token_type::SQBRACKET_CLOSED)
+    {
+        start++;
+        return std::make_shared<rs_list>(list);
+    }
 
     do
     {
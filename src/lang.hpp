@@ -25,9 +25,15 @@ struct rs_type_info
     bool optional = false;
     bool strict   = false;
     std::vector<rs_type_info> otherTypes = {}; // others if specified
+    std::vector<rs_type_info> mapped     = {}; // T of map<string, T>
+    inline bool isMap() const
+    {
+        return type_id == RS_MAP_KW_ID && array_count == 0;
+    }
     inline std::string tostr()
     {
         std::string typestr = std::to_string(type_id);
+        if (!mapped.empty()) typestr += '<' + mapped.front().tostr() + '>';
         if (optional) typestr.push_back('?');
         if (strict)   typestr.push_back('!');
         for(size_t i = 0; i < otherTypes.size(); i++)
@@ -40,14 +46,19 @@ struct rs_type_info
     }
     inline rs_type_info element_type()
     {
-        if (array_count < 1) return *this;
+        // the element of a map is its value.
+        if (array_count < 1) return isMap() && !mapped.empty() ? mapped.front() : *this;
 
-        return rs_type_info{type_id, array_count - 1, optional, strict, otherTypes};
+        return rs_type_info{type_id, array_count - 1, optional, strict, otherTypes, mapped};
+    }
+    inline bool sameMapped(const rs_type_info& other)
+    {
+        return mapped.size() == other.mapped.size() && (mapped.empty() || mapped.front().equals(other.mapped.front()));
     }
 
     inline bool equals(const rs_type_info& other)
     {
-        return (optional && other.type_id == RS_NULL_KW_ID) || (other.type_id == type_id && other.array_count == array_count && other.optional == optional && other.strict == strict) || canConvertTo(other);
+        return (optional && other.type_id == RS_NULL_KW_ID) || (other.type_id == type_id && other.array_count == array_count && other.optional == optional && other.strict == strict && sameMapped(other)) || canConvertTo(other);
     }
     inline bool equals(int32_t type)
     {
@@ -63,6 +74,7 @@ struct rs_type_info
     {
         return other.type_id == type_id         &&
                other.array_count == array_count &&
+               sameMapped(other)                &&
                ((other.optional && !strict) || other.optional == optional || other.strict == strict);
     }
 };
@@ -161,4 +173,7 @@ bst_operation<token> make_bst(rbc_program& program, token_list& tlist, size_t& s
 rs_expression expreval(rbc_program& program, token_list& tlist, size_t& start, rs_error* err,
                         bool br = false, bool lineEnd = true, bool obj = false, bool prune = true);
 std::shared_ptr<rs_object> parseInlineObject(rbc_program& program, token_list& tlist, size_t& start, rs_error* err);
+// snbt of the literal an object member is declared with ('optional x: int = 1;'), empty if it has none or it
+// isn't a literal. members that are kept without a default ('seperate x: int;') start as the zero of their type.
+std::string memberDefault(const rs_object::_MemberT& member);
 std::shared_ptr<rs_list>   parseList(rbc_program& program, token_list& tlist, size_t& start, rs_error* err);
\ No newline at end of file
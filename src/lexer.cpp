@@ -1,4 +1,5 @@
 #include "lexer.hpp"
+#include "file.hpp"
 // ex:
 // LEX_ERROR(RS_SYNTAX_ERROR, "Something went wrong because of the number {}", 44);
 #define LEX_ERROR(_ec, message, ...)                                    \
@@ -90,6 +91,9 @@ token_list tlex(const std::string &fName, std::string &content, rs_error *err =
             {
                 if (ch == '.')
                 {
+                    // 4..10 is a range, not a float.
+                    if (_At + 1 < S && content.at(_At + 1) == '.')
+                        break;
                     if (decimal)
                         LEX_ERROR(RS_SYNTAX_ERROR, "Invalid floating point notation.");
                     decimal = true;
@@ -110,6 +114,26 @@ token_list tlex(const std::string &fName, std::string &content, rs_error *err =
             bool isSelectorLiteral = ch == '@';
             long start = isSelectorLiteral ? _At + 1 : _At;
             while ((ch = adv()) && (std::isalpha(ch) || ch == '_'));
+            // arguments are part of the selector, @e[type=zombie,name="a b"] is one token.
+            if (isSelectorLiteral && ch == '[')
+            {
+                int depth = 0;
+                char quote = 0;
+                do
+                {
+                    if (quote)
+                        quote = ch == quote ? 0 : quote;
+                    else if (ch == '"' || ch == '\'')
+                        quote = ch;
+                    else if (ch == '[')
+                        depth++;
+                    else if (ch == ']' && --depth == 0)
+                        break;
+                } while ((ch = adv()));
+                if (depth != 0)
+                    LEX_ERRORF(RS_SYNTAX_ERROR, "Unterminated selector arguments.", start);
+                adv();
+            }
 
             token t{content.substr(start, _At - start),
                 isSelectorLiteral ? token_type::SELECTOR_LITERAL : token_type::WORD,
@@ -224,6 +248,16 @@ token_list tlex(const std::string &fName, std::string &content, rs_error *err =
                 }
                 break;
             }
+            case '.':
+            {
+                if (_At + 1 < S && content.at(_At + 1) == '.')
+                {
+                    adv();
+                    customType = token_type::RANGE;
+                    repr.push_back('.');
+                }
+                break;
+            }
             case '(':
                 customType = token_type::BRACKET_OPEN;
                 break;
@@ -251,3 +285,29 @@ token_list tlex(const std::string &fName, std::string &content, rs_error *err =
 }
 #undef LEX_ERRORF
 #undef LEX_ERROR
+std::shared_ptr<const lex_cache::entry> lex_cache::get(const std::filesystem::path& path, rs_error* err)
+{
+    const std::string key = std::filesystem::absolute(path).lexically_normal().string();
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        auto found = _entries.find(key);
+        if (found != _entries.end())
+            return found->second;
+    }
+    // lexed outside the lock, two threads may lex the same file once each.
+    auto lexed = std::make_shared<entry>();
+    lexed->content = readFile(path);
+    if (lexed->content.empty())
+        return nullptr;
+    lexed->tokens = tlex(path.string(), lexed->content, err);
+    if (err->trace.ec)
+        return lexed;
+
+    std::lock_guard<std::mutex> guard(_lock);
+    return _entries.emplace(key, lexed).first->second;
+}
+void lex_cache::invalidate(const std::filesystem::path& path)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _entries.erase(std::filesystem::absolute(path).lexically_normal().string());
+}
@@ -3,6 +3,9 @@
 #include <vector>
 #include <unordered_map>
 #include <tuple>
+#include <mutex>
+#include <memory>
+#include <filesystem>
 #include "token.hpp"
 #include "error.hpp"
 #include "constants.hpp"
@@ -13,3 +16,23 @@ struct lex_info
 };
 
 token_list tlex(const std::string&, std::string&, rs_error*);
+
+// files read and lexed once, and shared by every program that uses them.
+class lex_cache
+{
+public:
+    struct entry
+    {
+        std::string content;
+        token_list  tokens;
+    };
+    // nullptr if the file is missing or empty. a file that fails to lex sets err and is not kept.
+    std::shared_ptr<const entry> get(const std::filesystem::path& path, rs_error* err);
+    // drops a file that changed on disk, it is read again on the next get.
+    void invalidate(const std::filesystem::path& path);
+
+private:
+    std::mutex _lock;
+    std::unordered_map<std::string, std::shared_ptr<const entry>> _entries;
+};
+
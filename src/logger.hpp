@@ -1,6 +1,18 @@
 #pragma once
 #include <cstdio>
 
+enum rs_log_level
+{
+    RS_LOG_WARN,
+    RS_LOG_ERROR
+};
+// warnings and errors go to the diagnostics of the current rs_context, and are printed unless it is quiet.
+void rs_log(rs_log_level level, const char* prefix, const char* suffix, const char* format, ...)
+#ifdef __GNUC__
+    __attribute__((format(printf, 4, 5)))
+#endif
+    ;
+
 #define INFO(x, ...) printf("[INFO] " x "\n", ##__VA_ARGS__)
 
 #if 1
@@ -8,14 +20,14 @@
 #define ERROR_COLOR "\x1b[31m"
 #define ERROR_RESET "\x1b[0m"
 
-#define ERROR(x, ...) printf("\x1b[31m[ERROR] " x "\x1b[0m\n", ##__VA_ARGS__);
+#define ERROR(x, ...) rs_log(RS_LOG_ERROR, "\x1b[31m[ERROR] ", "\x1b[0m\n", x, ##__VA_ARGS__);
 #define SUCCESS(x,  ...) printf("\x1b[32m[SUCCESS] " x "\x1b[0m\n", ##__VA_ARGS__);
-#define WARN(x,  ...) printf("\x1b[33m[WARN] " x "\x1b[0m\n", ##__VA_ARGS__);
+#define WARN(x,  ...) rs_log(RS_LOG_WARN, "\x1b[33m[WARN] ", "\x1b[0m\n", x, ##__VA_ARGS__);
 #define UNIMPORTANT(x, ...) printf("\x1b[30m[UNIMPORTANT] " x "\x1b[0m\n", ##__VA_ARGS__);
 #else
-#define ERROR(x, ...) printf("[ERROR] " x '\n', __VA_ARGS__)
+#define ERROR(x, ...) rs_log(RS_LOG_ERROR, "[ERROR] ", "\n", x, ##__VA_ARGS__)
 #define SUCCESS(x,  ...) printf("[SUCCESS] " x '\n', __VA_ARGS__)
-#define WARN(x,  ...) printf("[WARN] " x '\n', __VA_ARGS__)
+#define WARN(x,  ...) rs_log(RS_LOG_WARN, "[WARN] ", "\n", x, ##__VA_ARGS__)
 #define UNIMPORTANT(x, ...) printf("[UNIMPORTANT] " x '\n', ##__VA_ARGS__);
 
 #endif
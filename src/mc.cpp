@@ -27,6 +27,11 @@ mc_command::_This mc_command::addroot()
     case MC_RETURN_CMD_ID:
         name = "return";
         break;
+    case MC_TAG_CMD_ID:
+        name = "tag";
+        break;
+    case MC_RAW_CMD_ID:
+        return THIS;
     default:
         WARN("Unknown command.");
         break;
@@ -187,6 +192,16 @@ const std::filesystem::path makeDatapack(const std::filesystem::path &path)
 
     return funcDir;
 }
+std::string mc_function::path() const
+{
+    std::string p;
+    for (const std::string& _module : modulePath)
+        p += _module + '/';
+
+    if (!parentalHashStr.empty())
+        p += parentalHashStr + '_';
+    return p + name;
+}
 std::shared_ptr<comparison_register> mc_program::getFreeComparisonRegister()
 {
     for (std::shared_ptr<comparison_register> reg : comparisonRegisters)
@@ -196,7 +211,35 @@ std::shared_ptr<comparison_register> mc_program::getFreeComparisonRegister()
     }
     return nullptr;
 }
-void writemc(mc_program &program, std::string name, const std::string &path, std::string &err)
+std::string mc_program::addGeneratedFunction(const mccmdlist &commands, const std::string &ns)
+{
+    uint64_t hash = util::stableHash("generated");
+    for (const mc_command &cmd : commands)
+        hash = util::stableHash(cmd.body + '\n', hash);
+
+    mc_function function;
+    function.name = util::hashToHex(hash);
+    function.modulePath = {MC_GENERATED_FOLDER};
+    function.generated = true;
+
+    const std::string location = function.location(ns);
+    for (const mc_function &other : functions)
+        if (other.generated && other.name == function.name)
+            return location;
+
+    function.commands = commands;
+    functions.push_back(std::move(function));
+    return location;
+}
+std::filesystem::path datapackFolder(std::string name, const std::string &path)
+{
+    toLower(name);
+    if (!name.ends_with(".mcfunction"))
+        name += ".mcfunction";
+    const std::filesystem::path safeName = removeSpecialCharacters(name);
+    return std::filesystem::path(RS_CONFIG.getOr<std::string>("mcpath", "")) / path / MC_DATAPACK_FOLDER / safeName.stem();
+}
+void writemc(mc_program &program, std::string name, const std::string &path, std::string &err, mc_write_state *state)
 {
     if (!RS_CONFIG.exists("mcpath"))
     {
@@ -206,13 +249,52 @@ void writemc(mc_program &program, std::string name, const std::string &path, std
 
     toLower(name);
 
+    std::unordered_map<std::string, uint64_t> written;
     auto writeFunction = [&](mc_function &func, const std::filesystem::path &path)
     {
+        if (state)
+        {
+            uint64_t hash = util::stableHash("");
+            for (auto &command : func.commands)
+                hash = util::stableHash(command.body + '\n', hash);
+            written[path.string()] = hash;
+
+            auto last = state->files.find(path.string());
+            if (last != state->files.end() && last->second == hash && std::filesystem::exists(path))
+            {
+                state->unchanged++;
+                return true;
+            }
+            state->written++;
+        }
         std::ofstream stream(path);
         for (auto &command : func.commands)
             stream << command.body << '\n';
         stream.close();
-        return true;
+        return stream.good();
+    };
+    if (state)
+        state->written = state->unchanged = state->removed = 0;
+
+    const bool sourceMap = !program.sources.empty() && RS_CONFIG.getOr<int>("source_map", 1);
+    std::stringstream map;
+    for (size_t i = 0; i < program.sources.size(); i++)
+        map << "file\t" << i << '\t' << program.sources.at(i) << '\n';
+    auto mapFunction = [&](const mc_function &func, const std::string &location)
+    {
+        for (size_t first = 0, last; first < func.commands.size(); first = last)
+        {
+            const source_location &origin = func.commands.at(first).origin;
+            for (last = first + 1; last < func.commands.size(); last++)
+            {
+                const source_location &next = func.commands.at(last).origin;
+                if (next.file != origin.file || next.line != origin.line || next.column != origin.column)
+                    break;
+            }
+            if (origin.line)
+                map << location << '\t' << first + 1 << '\t' << last << '\t' << origin.file << '\t'
+                    << origin.line << '\t' << origin.column << '\n';
+        }
     };
     try
     {
@@ -236,36 +318,35 @@ void writemc(mc_program &program, std::string name, const std::string &path, std
             err = std::format("Could not write function to '{}'.", to.string());
             return;
         }
+        if (sourceMap)
+            mapFunction(program.globalFunction, safeName.stem().string());
         for (auto &function : program.functions)
         {
+            to = funcPath / (function.path() + ".mcfunction");
+            std::filesystem::create_directories(to.parent_path());
 
-            std::filesystem::path parentHashPath;
-
-            if (function.modulePath.size() == 0)
-            {
-                if (function.parentalHashStr.empty())
-                    to = funcPath / (function.name + ".mcfunction");
-                else
-                    to = funcPath / (function.parentalHashStr + '_' + function.name + ".mcfunction");
-            }
-            else
-            {
-                to = funcPath;
-                for(std::string& _module : function.modulePath)
-                {
-                    to /= _module;
-                    // maybe trying to create way too many directories.
-                    // TODO: fix!
-                    std::filesystem::create_directory(to);
-                }
-
-                if (function.parentalHashStr.empty())
-                    to /= (function.name + ".mcfunction");
-                else
-                    to /= (function.parentalHashStr + '_' + function.name + ".mcfunction");
-            }
             if (!writeFunction(function, to))
                 goto _error;
+            if (sourceMap)
+                mapFunction(function, function.path());
+        }
+        if (sourceMap)
+        {
+            to = mcpath / (safeName.stem().string() + ".rsmap");
+            std::ofstream stream(to);
+            stream << map.str();
+            stream.close();
+            if (!stream.good())
+                goto _error;
+        }
+        if (state)
+        {
+            for (auto &[file, hash] : state->files)
+            {
+                if (written.find(file) == written.end() && std::filesystem::remove(file))
+                    state->removed++;
+            }
+            state->files = std::move(written);
         }
         // TODO: other functions
     }
@@ -15,6 +15,9 @@
 #define MC_TELLRAW_CMD_ID 4
 #define MC_KILL_CMD_ID 5
 #define MC_RETURN_CMD_ID 6
+// already rooted, addroot leaves the body as is.
+#define MC_RAW_CMD_ID 7
+#define MC_TAG_CMD_ID 8
 #define THIS *this;
 
 typedef unsigned int uint;
@@ -29,6 +32,8 @@ struct mc_command
     bool        macro;
     uint        cmd;
     std::string body;
+    // redscript source the command was compiled from.
+    source_location origin = {};
 
     constexpr inline bool isexec()
     { return cmd == MC_EXEC_CMD_ID; }
@@ -53,6 +58,22 @@ struct mc_function
     std::vector<mc_command> commands;
     std::vector<std::string> modulePath;
     std::string parentalHashStr = "";
+    // made by the compiler rather than declared by the user. generated functions
+    // have no user facing name, and can be merged or renamed freely.
+    bool generated = false;
+    // called through a name computed at runtime (macros), so its path must not change.
+    bool pinned = false;
+    // qualified name of the redscript function this was compiled from, for reports.
+    std::string source = "";
+    // most commands this function may run in one tick (budget decorator), -1 for none.
+    int budget = -1;
+
+    // path of the function relative to the namespace, without extension.
+    std::string path() const;
+    inline std::string location(const std::string& ns) const
+    { return ns + ':' + path(); }
+    inline bool internal() const
+    { return (generated || !parentalHashStr.empty()) && !pinned; }
 };
 struct comparison_register
 {
@@ -74,9 +95,31 @@ struct mc_program
     // parameter name: parameter id
     std::vector<rs_variable*> stack;
     mc_function globalFunction;
+    // files the origins of commands index into, set by whoever compiled the program. writemc writes a
+    // source map when there are any.
+    std::vector<std::string> sources;
 
     std::shared_ptr<comparison_register> getFreeComparisonRegister();
-    
+    // adds a generated function holding the (rooted) commands, named after their contents,
+    // and returns its location. identical command lists share one function.
+    std::string addGeneratedFunction(const mccmdlist& commands, const std::string& ns);
+
+};
+// what writemc wrote for a program last time, so a rebuild only touches the files that changed.
+struct mc_write_state
+{
+    // file path: hash of the content written.
+    std::unordered_map<std::string, uint64_t> files;
+    // counts for the last write.
+    size_t written = 0, unchanged = 0, removed = 0;
 };
 const std::filesystem::path makeDatapack(const std::filesystem::path&);
-void writemc(mc_program&, std::string, const std::string&, std::string&);
\ No newline at end of file
+// the folder writemc writes the datapack called name into, in the world at path under 'mcpath'.
+std::filesystem::path datapackFolder(std::string name, const std::string& path);
+// with a state, files that have the same content as last time are not written again, and files
+// that were written last time but are no longer part of the program are removed.
+// with sources set (and 'source_map' not 0), also writes <name>.rsmap into the datapack folder:
+//   file\t<index>\t<path>                                              for every source file, then
+//   <function path>\t<first line>\t<last line>\t<file>\t<line>\t<column>  for every run of lines
+// with the same origin. lines are 1 based, commands without an origin are left out.
+void writemc(mc_program&, std::string, const std::string&, std::string&, mc_write_state* state = nullptr);
\ No newline at end of file
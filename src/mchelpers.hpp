@@ -60,10 +60,10 @@
 #pragma region tellraw
 #define MC_TELLRAW_CONST(selector, val) '@' INS(selector) SEP INS_L(val)
 
-// DONT USE: not finished
-#define MC_TELLRAW_OPERABLE_REGISTER(selector, id) '@' INS(selector) SEP "[{\"score\":{" MC_OPERABLE_REG(id) ".value}, {\"storage\":\"" RS_PROGRAM_DATA "\"}"
-// for tellraw in particular a function needs to be made. Coming in next version.
-#define MC_TELLRAW_VARIABLE(selector, id) '@' INS(selector) SEP "[{\"nbt\":\"" ARR_AT(RS_PROGRAM_VARIABLES, STR(id))".value\", \"storage\":\"" RS_PROGRAM_STORAGE "\"}]"
+// components of a tellraw message.
+#define MC_TELLRAW_NBT(path) "{\"nbt\":\"" INS(path) "\", \"storage\":\"" RS_PROGRAM_STORAGE "\"}"
+#define MC_TELLRAW_SCORE(id) "{\"score\":{\"name\":\"" RBC_REGISTER_PLAYER "\", \"objective\":\"" MC_OPERABLE_REG_RAW(INS(STR(id))) "\"}}"
+#define MC_TELLRAW_SELECTOR(selector) "{\"selector\":" INS(selector) "}"
 #pragma endregion tellraw
 
 #pragma region mcmeta
@@ -84,9 +84,34 @@
 
 #pragma endregion conditionals
 
+#pragma region lists
+// macro arguments of a list element helper, the index is their 'value'.
+#define MC_LIST_INDEX_ARGUMENTS RS_PROGRAM_DATA ".index"
+#define MC_LIST_INDEX MC_LIST_INDEX_ARGUMENTS ".value"
+// what rotating a list counts with, when there are no macros.
+#define MC_LIST_ROTATE_SCORE "_idx" SEP MC_TEMP_STORAGE_NAME
+#define MC_LIST_LENGTH_SCORE "_len" SEP MC_TEMP_STORAGE_NAME
+#pragma endregion lists
+
+#pragma region maps
+// a map is {keys:[{k:<key>}, ...], values:{<key>:<value>, ...}}. values are read by their key, keys is what
+// the map is iterated by.
+#define MC_MAP_EMPTY "{keys:[],values:{}}"
+#define MC_MAP_VALUE(map, key) (map) + ".values.\"" + (key) + "\""
+#define MC_MAP_KEYS(map) (map) + ".keys"
+#define MC_MAP_KEY_ENTRY(key) "{k:\"" + (key) + "\"}"
+#define MC_MAP_KEY(map, key) MC_MAP_KEYS(map) + "[" + MC_MAP_KEY_ENTRY(key) + "]"
+// a stack with one list per running map loop, of the keys it has yet to run for. the loop pops them from the
+// front of its own list, the top one, so nested and recursive loops each have their own.
+#define MC_MAP_KEYS_LEFT RS_PROGRAM_DATA ".keys"
+#define MC_MAP_KEYS_LEFT_TOP MC_MAP_KEYS_LEFT "[-1]"
+#pragma endregion maps
+
 #pragma region temporary_storage
 #define MC_TEMP_STORAGE RS_PROGRAM_STORAGE SEP MC_TEMP_STORAGE_NAME
 #define MC_TEMP_SCOREBOARD_STORAGE RBC_REGISTER_PLAYER SEP MC_TEMP_STORAGE_NAME
+// second operand of score comparisons against temp.
+#define MC_TEMP_SCOREBOARD_RHS "_RHS" SEP MC_TEMP_STORAGE_NAME
 #define MC_TEMP_STORAGE_SET_CONST(val) MC_DATA(modify storage, MC_TEMP_STORAGE_NAME) PAD(set value) INS_L(val)
 #define MC_TEMP_STORAGE_SCOREBOARD_SET_CONST(val) PADR(players set) MC_TEMP_SCOREBOARD_STORAGE SEP INS_L(val)
 #define MC_TEMP_STORAGE_SCOREBOARD_SET_RAW_CONST(val) PADR(players set) MC_TEMP_SCOREBOARD_STORAGE SEP val
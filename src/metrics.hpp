@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// cost of a piece of work: wall time, cpu time, heap allocations and peak memory.
+namespace metrics
+{
+    // calls to operator new so far. stays 0 unless RS_COUNT_ALLOCATIONS is used in the executable.
+    inline std::atomic<size_t> allocations{0};
+
+    // user + system time of the process.
+    inline double cpuSeconds()
+    {
+#ifdef _WIN32
+        FILETIME creation, exit, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+            return 0;
+        auto seconds = [](const FILETIME& t) { return ((static_cast<unsigned long long>(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 1e7; };
+        return seconds(kernel) + seconds(user);
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#endif
+    }
+    // most memory the process has had resident at once, in KiB. it never goes down.
+    inline long peakRssKb()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return 0;
+        return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+#elif defined(__APPLE__)
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+#endif
+    }
+
+    struct sample
+    {
+        double wallMs      = 0;
+        double cpuMs       = 0;
+        size_t allocations = 0;
+        // after the work, not the increase.
+        long   peakRssKb   = 0;
+    };
+
+    class stopwatch
+    {
+        std::chrono::steady_clock::time_point _wall = std::chrono::steady_clock::now();
+        double _cpu         = cpuSeconds();
+        size_t _allocations = allocations.load(std::memory_order_relaxed);
+
+    public:
+        sample stop() const
+        {
+            return sample
+            {
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _wall).count(),
+                (cpuSeconds() - _cpu) * 1000,
+                allocations.load(std::memory_order_relaxed) - _allocations,
+                peakRssKb()
+            };
+        }
+    };
+}
+
+// replaces the global operator new/delete to count allocations in metrics::allocations.
+// use once, at namespace scope, in one source file of an executable.
+#define RS_COUNT_ALLOCATIONS                                                    \
+    void* operator new(std::size_t size)                                        \
+    {                                                                           \
+        metrics::allocations.fetch_add(1, std::memory_order_relaxed);           \
+        if (void* p = std::malloc(size ? size : 1))                             \
+            return p;                                                           \
+        throw std::bad_alloc();                                                 \
+    }                                                                           \
+    void operator delete(void* p) noexcept { std::free(p); }                    \
+    void operator delete(void* p, std::size_t) noexcept { std::free(p); }
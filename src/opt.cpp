@@ -0,0 +1,512 @@
+#include <algorithm>
+#include <unordered_set>
+#include "opt.hpp"
+
+namespace optimization
+{
+    static uint64_t hashCommands(const mccmdlist& commands)
+    {
+        uint64_t hash = util::stableHash("");
+        for (const mc_command& cmd : commands)
+        {
+            hash = util::stableHash(cmd.body, hash);
+            hash = util::stableHash(cmd.macro ? "\n$" : "\n", hash);
+        }
+        return hash;
+    }
+    static bool sameCommands(const mccmdlist& a, const mccmdlist& b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            if (a[i].macro != b[i].macro || a[i].body != b[i].body)
+                return false;
+        }
+        return true;
+    }
+    static size_t retargetCommands(mccmdlist& commands, const std::string& from, const std::string& to)
+    {
+        const std::string needle = "function " + from;
+        size_t count = 0;
+        for (mc_command& cmd : commands)
+        {
+            std::string& body = cmd.body;
+            size_t at = 0;
+            while ((at = body.find(needle, at)) != std::string::npos)
+            {
+                const size_t end = at + needle.size();
+                // make sure we matched the whole location, not a prefix of a longer one.
+                if ((at > 0 && body.at(at - 1) != ' ' && body.at(at - 1) != '$') ||
+                    (end < body.size() && body.at(end) != ' '))
+                {
+                    at = end;
+                    continue;
+                }
+                body.replace(at + 9, from.size(), to);
+                at += 9 + to.size();
+                count++;
+            }
+        }
+        return count;
+    }
+    size_t retarget(mc_program& program, const std::string& from, const std::string& to)
+    {
+        size_t count = retargetCommands(program.globalFunction.commands, from, to);
+        for (mc_function& function : program.functions)
+            count += retargetCommands(function.commands, from, to);
+        return count;
+    }
+    size_t dedupe(mc_program& program, const std::string& ns)
+    {
+        size_t removed = 0;
+        bool changed;
+        // merging two functions can make their callers identical, so repeat until nothing changes.
+        do
+        {
+            changed = false;
+            std::unordered_map<uint64_t, std::vector<size_t>> buckets;
+            for (size_t i = 0; i < program.functions.size(); i++)
+                buckets[hashCommands(program.functions[i].commands)].push_back(i);
+
+            std::vector<bool> erase(program.functions.size(), false);
+            for (auto& bucket : buckets)
+            {
+                std::vector<size_t>& candidates = bucket.second;
+                if (candidates.size() < 2)
+                    continue;
+                for (size_t c = 0; c < candidates.size(); c++)
+                {
+                    const size_t canonical = candidates[c];
+                    if (erase[canonical])
+                        continue;
+                    for (size_t o = c + 1; o < candidates.size(); o++)
+                    {
+                        size_t other = candidates[o];
+                        if (erase[other] || !sameCommands(program.functions[canonical].commands, program.functions[other].commands))
+                            continue;
+
+                        size_t keep = canonical, drop = other;
+                        if (program.functions[drop].internal() == false)
+                        {
+                            // never remove a user named function, keep it and drop the other instead.
+                            if (program.functions[keep].internal() == false)
+                                continue;
+                            std::swap(keep, drop);
+                        }
+                        retarget(program, program.functions[drop].location(ns), program.functions[keep].location(ns));
+                        erase[drop] = true;
+                        changed = true;
+                        removed++;
+                        if (drop == canonical)
+                            break;
+                    }
+                }
+            }
+            if (!changed)
+                break;
+
+            std::vector<mc_function> kept;
+            kept.reserve(program.functions.size());
+            for (size_t i = 0; i < program.functions.size(); i++)
+            {
+                if (!erase[i])
+                    kept.push_back(std::move(program.functions[i]));
+            }
+            program.functions = std::move(kept);
+        } while (changed);
+
+        return removed;
+    }
+    // commands that cannot be moved into another function without changing what they do.
+    static bool outlinable(const mc_command& cmd)
+    {
+        if (cmd.macro)
+            return false;
+        // 'return' would return from the helper instead of the function it was written in.
+        return !cmd.body.starts_with("return") && cmd.body.find(" return ") == std::string::npos;
+    }
+    // helpers are named after their commands.
+    static std::string helperName(const mccmdlist& commands)
+    {
+        uint64_t hash = util::stableHash("outline");
+        for (const mc_command& cmd : commands)
+            hash = util::stableHash(cmd.body + '\n', hash);
+        return util::hashToHex(hash);
+    }
+    size_t outline(mc_program& program, const std::string& ns, const outline_options& options)
+    {
+        // lists are numbered, 0 is the global function and i + 1 is program.functions[i]. helpers are appended
+        // to program.functions, which may reallocate, so occurrences don't hold pointers.
+        struct occurrence
+        {
+            size_t list;
+            size_t start;
+        };
+        auto listAt = [&](size_t id) -> mccmdlist&
+        { return id == 0 ? program.globalFunction.commands : program.functions.at(id - 1).commands; };
+
+        auto equalAt = [&](const occurrence& a, const occurrence& b, size_t length)
+        {
+            const mccmdlist& la = listAt(a.list);
+            const mccmdlist& lb = listAt(b.list);
+            for (size_t i = 0; i < length; i++)
+            {
+                if (la.at(a.start + i).body != lb.at(b.start + i).body)
+                    return false;
+            }
+            return true;
+        };
+
+        // every window of every length, bucketed by length then by hash of its commands. it is built once, and
+        // after each round only the lists that changed are indexed again. keys holds the buckets a list is in.
+        std::vector<std::unordered_map<uint64_t, std::vector<occurrence>>> windows(options.maxLength + 1);
+        std::vector<std::vector<std::pair<size_t, uint64_t>>> keys;
+        auto index = [&](size_t id)
+        {
+            if (keys.size() <= id)
+                keys.resize(id + 1);
+            const mccmdlist& list = listAt(id);
+            std::vector<uint64_t> hashes;
+            hashes.reserve(list.size());
+            for (const mc_command& cmd : list)
+                hashes.push_back(util::stableHash(cmd.body));
+
+            for (size_t start = 0; start < list.size(); start++)
+            {
+                uint64_t hash = util::stableHash("");
+                for (size_t length = 1; length <= options.maxLength && start + length <= list.size(); length++)
+                {
+                    if (!outlinable(list.at(start + length - 1)))
+                        break;
+                    hash = (hash ^ hashes[start + length - 1]) * 0x100000001b3ULL;
+                    if (length < options.minLength)
+                        continue;
+                    std::vector<occurrence>& bucket = windows[length][hash];
+                    if (bucket.empty() || bucket.back().list != id)
+                        keys[id].push_back({length, hash});
+                    bucket.push_back({id, start});
+                }
+            }
+        };
+        auto unindex = [&](size_t id)
+        {
+            for (auto& [length, hash] : keys[id])
+            {
+                auto bucket = windows[length].find(hash);
+                if (bucket == windows[length].end())
+                    continue;
+                std::erase_if(bucket->second, [id](const occurrence& o) { return o.list == id; });
+                if (bucket->second.empty())
+                    windows[length].erase(bucket);
+            }
+            keys[id].clear();
+        };
+
+        // helpers are never kept, so what is kept is decided once.
+        if (!(options.keep && options.keep(program.globalFunction)))
+            index(0);
+        for (size_t i = 0; i < program.functions.size(); i++)
+            if (!(options.keep && options.keep(program.functions[i])))
+                index(i + 1);
+
+        size_t made = 0;
+        for (size_t round = 0; round < options.maxRounds; round++)
+        {
+            int bestGain = options.minGain - 1;
+            size_t bestLength = 0;
+            std::vector<occurrence> best;
+            for (size_t length = options.minLength; length <= options.maxLength; length++)
+            {
+                for (auto& bucket : windows[length])
+                {
+                    std::vector<occurrence>& found = bucket.second;
+                    if (found.size() < 2)
+                        continue;
+
+                    // keep occurrences that match the first one and don't overlap each other. the occurrences
+                    // of one list are next to each other and in order, so only the last one can overlap.
+                    std::vector<occurrence> accepted;
+                    for (occurrence& o : found)
+                    {
+                        if (!accepted.empty())
+                        {
+                            occurrence& last = accepted.back();
+                            if (last.list == o.list && o.start < last.start + length)
+                                continue;
+                            if (!equalAt(accepted.front(), o, length))
+                                continue;
+                        }
+                        accepted.push_back(o);
+                    }
+                    // a helper made earlier with these commands is their call site already, an occurrence that
+                    // is its whole body would become a call to itself.
+                    std::erase_if(accepted, [&](const occurrence& o)
+                    {
+                        if (o.list == 0 || o.start != 0)
+                            return false;
+                        const mc_function& f = program.functions.at(o.list - 1);
+                        return f.generated && f.commands.size() == length && f.name == helperName(f.commands);
+                    });
+                    const int k = accepted.size(), L = length;
+                    if (k < 2)
+                        continue;
+                    // k * L commands become k calls and one helper of L commands,
+                    // each call costs callCost when run and the helper file costs functionCost.
+                    const int gain = (k * L - k - L) - k * options.callCost - options.functionCost;
+                    if (gain > bestGain)
+                    {
+                        bestGain   = gain;
+                        bestLength = length;
+                        best       = std::move(accepted);
+                    }
+                }
+            }
+            if (best.empty())
+                break;
+
+            const mccmdlist& from = listAt(best.front().list);
+            mc_function helper;
+            helper.commands.assign(from.begin() + best.front().start, from.begin() + best.front().start + bestLength);
+            helper.name = helperName(helper.commands);
+            helper.modulePath = {MC_GENERATED_FOLDER};
+            helper.generated = true;
+            // the same commands can be outlined again once other helpers changed their surroundings, the
+            // helper made then is called instead of adding a second file with the same name.
+            const bool exists = std::any_of(program.functions.begin(), program.functions.end(),
+                [&](const mc_function& f) { return f.generated && f.name == helper.name; });
+
+            const mc_command call{false, MC_FUNCTION_CMD_ID, "function " + helper.location(ns)};
+            std::vector<size_t> changed;
+            // replace back to front so earlier starts stay valid.
+            for (auto it = best.rbegin(); it != best.rend(); ++it)
+            {
+                mccmdlist& commands = listAt(it->list);
+                commands.erase(commands.begin() + it->start, commands.begin() + it->start + bestLength);
+                commands.insert(commands.begin() + it->start, call);
+                if (std::find(changed.begin(), changed.end(), it->list) == changed.end())
+                    changed.push_back(it->list);
+            }
+            for (size_t id : changed)
+            {
+                unindex(id);
+                index(id);
+            }
+            if (!exists)
+            {
+                program.functions.push_back(std::move(helper));
+                index(program.functions.size());
+                made++;
+            }
+        }
+        return made;
+    }
+    struct selector_use
+    {
+        size_t start, length;
+        // the selector as a command argument, without the escapes of a json string.
+        std::string selector;
+    };
+    // '@e[...]' selectors in a command that would be cheaper to find by tag. inside a string, a selector only
+    // counts as the selector component of a tellraw.
+    static std::vector<selector_use> selectorUses(const std::string& body)
+    {
+        static const std::string component = "\"selector\":\"";
+        // these depend on where and as whom the command runs, or pick some of the entities found.
+        static const std::unordered_set<std::string> contextual = {
+            "x", "y", "z", "dx", "dy", "dz", "distance", "x_rotation", "y_rotation", "sort", "limit"
+        };
+        std::vector<selector_use> uses;
+        char quote = 0;
+        for (size_t i = 0; i < body.size(); i++)
+        {
+            const char c = body[i];
+            const bool selector = body.compare(i, 3, "@e[") == 0 &&
+                (!quote || (quote == '"' && i >= component.size() && body.compare(i - component.size(), component.size(), component) == 0));
+            if (!selector)
+            {
+                if (quote && c == '\\')
+                    i++;
+                else if (quote && c == quote)
+                    quote = 0;
+                else if (!quote && (c == '"' || c == '\''))
+                    quote = c;
+                continue;
+            }
+            // in a json string, the escaped quotes are the quotes of the selector.
+            std::string unescaped = "@e[", key;
+            std::vector<std::string> keys;
+            char inner = 0;
+            int depth = 1;
+            size_t end = i + 3;
+            for (; end < body.size() && depth; end++)
+            {
+                const char d = body[end];
+                if (d == '\\' && quote)
+                    continue;
+                unescaped += d;
+                if (inner)
+                {
+                    if (d == inner)
+                        inner = 0;
+                }
+                else if (d == '"' || d == '\'')
+                    inner = d;
+                else if (d == '[' || d == '{')
+                    depth++;
+                else if (d == ']' || d == '}')
+                    depth--;
+                else if (depth == 1 && d == '=')
+                    keys.push_back(key);
+                else if (depth == 1 && d == ',')
+                    key.clear();
+                else if (depth == 1 && d != ' ')
+                    key += d;
+            }
+            if (depth)
+                break;
+            const bool tagged  = std::all_of(keys.begin(), keys.end(), [](const std::string& k) { return k == "tag"; });
+            const bool context = std::any_of(keys.begin(), keys.end(), [](const std::string& k) { return contextual.count(k) > 0; });
+            if (!tagged && !context)
+                uses.push_back({i, end - i, unescaped});
+            i = end - 1;
+        }
+        return uses;
+    }
+    // a use at 'at' only runs when an earlier execute condition passes.
+    static bool guarded(const std::string& body, size_t at)
+    {
+        if (!body.starts_with("execute "))
+            return false;
+        const size_t conditions = std::min(at, body.find(" run "));
+        for (const char* word : {" if ", " unless "})
+        {
+            const size_t found = body.find(word);
+            if (found != std::string::npos && found < conditions)
+                return true;
+        }
+        return false;
+    }
+    // commands that can't change which entities a selector finds, except by killing them, and don't leave the
+    // function. a tag added before them still stands for the selector after them.
+    static bool keepsSelection(const mc_command& cmd)
+    {
+        if (cmd.macro)
+            return false;
+        std::vector<std::string> words;
+        for (size_t start = 0, end; start < cmd.body.size(); start = end + 1)
+        {
+            end = cmd.body.find(' ', start);
+            if (end == std::string::npos)
+                end = cmd.body.size();
+            if (end > start)
+                words.push_back(cmd.body.substr(start, end - start));
+        }
+        if (words.empty() || std::find(words.begin(), words.end(), "function") != words.end() ||
+            std::find(words.begin(), words.end(), "return") != words.end())
+            return false;
+        size_t verb = 0;
+        if (words.front() == "execute")
+        {
+            for (verb = 1; verb < words.size() && words.at(verb) != "run"; verb++)
+            {
+                if (words.at(verb) != "store" || verb + 3 >= words.size())
+                    continue;
+                const std::string& kind = words.at(verb + 2);
+                if (kind == "entity" || (kind == "score" && words.at(verb + 3).starts_with('@')))
+                    return false;
+            }
+            // only conditions and stores.
+            if (++verb >= words.size())
+                return true;
+        }
+        const std::string& name = words.at(verb);
+        if (name == "tellraw" || name == "kill")
+            return true;
+        if (name == "data")
+            return verb + 2 < words.size() && words.at(verb + 2) == "storage";
+        if (name == "scoreboard")
+            return verb + 3 < words.size() && (words.at(verb + 1) == "objectives" || !words.at(verb + 3).starts_with('@'));
+        return false;
+    }
+    static size_t cacheSelectorsIn(mccmdlist& commands, const selector_cache_options& options)
+    {
+        // tags are numbered per function, so functions that are otherwise the same still dedupe. a tag is never
+        // on across a function call, a call ends the run it is used in.
+        size_t tags = 0;
+        // commands to insert before the command at an index, in order.
+        std::vector<std::pair<size_t, mc_command>> inserts;
+        size_t cached = 0, runStart = 0;
+        for (size_t i = 0; i <= commands.size(); i++)
+        {
+            if (i < commands.size() && keepsSelection(commands.at(i)))
+                continue;
+            // every selector of the run, the commands that use it and whether any use always runs, in the order
+            // they are first used.
+            struct found_selector
+            {
+                std::string selector;
+                std::vector<size_t> users;
+                bool unguarded = false;
+            };
+            std::vector<found_selector> found;
+            for (size_t c = runStart; c < i; c++)
+            {
+                const std::string& body = commands.at(c).body;
+                for (const selector_use& use : selectorUses(body))
+                {
+                    auto it = std::find_if(found.begin(), found.end(), [&](const auto& f) { return f.selector == use.selector; });
+                    if (it == found.end())
+                        it = found.insert(found.end(), {use.selector, {}});
+                    it->users.push_back(c);
+                    it->unguarded |= !guarded(body, use.start);
+                }
+            }
+            runStart = i + 1;
+            for (auto& [selector, users, unguarded] : found)
+            {
+                // the tag commands always scan, when every use is guarded they may scan more than the uses would.
+                if (users.size() < options.minUses || !unguarded)
+                    continue;
+                const std::string tag = "_rs_sel" + std::to_string(tags++);
+                const std::string tagged = "@e[tag=" + tag + ']';
+                for (size_t c : users)
+                {
+                    std::string& body = commands.at(c).body;
+                    std::vector<selector_use> uses = selectorUses(body);
+                    // replace back to front so earlier starts stay valid.
+                    for (auto use = uses.rbegin(); use != uses.rend(); ++use)
+                        if (use->selector == selector)
+                            body.replace(use->start, use->length, tagged);
+                }
+                inserts.push_back({users.front(), mc_command{false, MC_TAG_CMD_ID, "tag " + selector + " add " + tag,
+                                                             commands.at(users.front()).origin}});
+                inserts.push_back({users.back() + 1, mc_command{false, MC_TAG_CMD_ID, "tag " + tagged + " remove " + tag,
+                                                                commands.at(users.back()).origin}});
+                cached++;
+            }
+        }
+        if (inserts.empty())
+            return 0;
+        std::stable_sort(inserts.begin(), inserts.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        mccmdlist rewritten;
+        rewritten.reserve(commands.size() + inserts.size());
+        size_t next = 0;
+        for (size_t i = 0; i <= commands.size(); i++)
+        {
+            for (; next < inserts.size() && inserts.at(next).first == i; next++)
+                rewritten.push_back(inserts.at(next).second);
+            if (i < commands.size())
+                rewritten.push_back(std::move(commands.at(i)));
+        }
+        commands = std::move(rewritten);
+        return cached;
+    }
+    size_t cacheSelectors(mc_program& program, const selector_cache_options& options)
+    {
+        size_t cached = cacheSelectorsIn(program.globalFunction.commands, options);
+        for (mc_function& function : program.functions)
+            cached += cacheSelectorsIn(function.commands, options);
+        return cached;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <functional>
+#include "mc.hpp"
+
+// passes that run over a finished mc_program, before it is written.
+namespace optimization
+{
+    // rewrites every 'function <from>' reference in the program to 'function <to>'.
+    // both must be full locations (namespace:path).
+    size_t retarget(mc_program& program, const std::string& from, const std::string& to);
+
+    // merges functions that have byte identical command lists into one file.
+    // only internal functions are removed, user named functions are always kept.
+    // returns the amount of functions removed.
+    size_t dedupe(mc_program& program, const std::string& ns);
+
+    struct outline_options
+    {
+        size_t minLength = 2;
+        size_t maxLength = 12;
+        // cost of executing one extra 'function' command, in commands.
+        int callCost     = 1;
+        // cost of one extra .mcfunction file to parse and store, in commands.
+        int functionCost = 1;
+        // the least amount of commands a helper has to save to be made.
+        int minGain      = 1;
+        size_t maxRounds = 256;
+        // functions this returns true for are left as they are, nothing is outlined from them.
+        std::function<bool(const mc_function&)> keep;
+    };
+    // moves command sequences that repeat across functions into shared helper functions,
+    // whenever the commands saved outweigh the extra calls made.
+    // returns the amount of helpers made.
+    size_t outline(mc_program& program, const std::string& ns, const outline_options& options = {});
+
+    struct selector_cache_options
+    {
+        // scans with one selector in a run of commands before its entities are tagged.
+        size_t minUses = 2;
+    };
+    // an '@e[...]' selector used repeatedly in one function is run once to tag its entities
+    // ('tag @e[...] add _rs_sel<n>'), and the uses after it select '@e[tag=_rs_sel<n>]' instead. the tag is
+    // removed after the last use. uses are only cached between commands that can't change what the selector
+    // finds or leave the function, and when at least one of them isn't behind an execute condition. tags are
+    // numbered per function. returns the amount of selectors cached.
+    size_t cacheSelectors(mc_program& program, const selector_cache_options& options = {});
+}
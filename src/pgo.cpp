@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <map>
+#include "pgo.hpp"
+#include "file.hpp"
+#include "util.hpp"
+
+namespace pgo
+{
+    long long profile::calls(const std::string& function) const
+    {
+        auto found = functions.find(function);
+        return found == functions.end() ? -1 : found->second.calls;
+    }
+    long long profile::count(const std::string& function, uint32_t line) const
+    {
+        auto found = functions.find(function);
+        if (found == functions.end())
+            return -1;
+        auto counted = found->second.lines.find(line);
+        return counted == found->second.lines.end() ? 0 : counted->second;
+    }
+    long long profile::hottest() const
+    {
+        long long most = 0;
+        for (auto& [name, function] : functions)
+        {
+            most = std::max(most, function.calls);
+            for (auto& [line, count] : function.lines)
+                most = std::max(most, count);
+        }
+        return most;
+    }
+    static heat classify(const profile& p, long long count)
+    {
+        if (count < 0)
+            return heat::UNKNOWN;
+        if (count == 0)
+            return heat::COLD;
+        return count * 100 >= p.hottest() * p.hotPercent ? heat::HOT : heat::WARM;
+    }
+    heat profile::of(const std::string& function) const
+    {
+        return classify(*this, calls(function));
+    }
+    heat profile::of(const std::string& function, uint32_t line) const
+    {
+        return classify(*this, count(function, line));
+    }
+
+    // just enough JSON for profiles: objects, strings and integers. anything else is skipped.
+    class json_reader
+    {
+    public:
+        json_reader(const std::string& text) : _text(text) {}
+
+        bool failed() const { return !_error.empty(); }
+        const std::string& error() const { return _error; }
+
+        // calls member(key) for every member, which has to read or skip the value.
+        template<typename _Member>
+        void object(_Member member)
+        {
+            if (!expect('{'))
+                return;
+            if (peek() == '}')
+            {
+                _at++;
+                return;
+            }
+            do
+            {
+                std::string key = string();
+                if (failed() || !expect(':'))
+                    return;
+                member(key);
+                if (failed())
+                    return;
+            } while (peek() == ',' && ++_at);
+            expect('}');
+        }
+        std::string string()
+        {
+            std::string out;
+            if (!expect('"'))
+                return out;
+            while (_at < _text.size() && _text[_at] != '"')
+            {
+                if (_text[_at] == '\\' && _at + 1 < _text.size())
+                    _at++;
+                out += _text[_at++];
+            }
+            expect('"');
+            return out;
+        }
+        long long integer()
+        {
+            peek();
+            const size_t start = _at;
+            if (_at < _text.size() && _text[_at] == '-')
+                _at++;
+            while (_at < _text.size() && std::isdigit(static_cast<unsigned char>(_text[_at])))
+                _at++;
+            long long value = 0;
+            auto [last, ec] = std::from_chars(_text.data() + start, _text.data() + _at, value);
+            if (start == _at || ec != std::errc() || last != _text.data() + _at)
+            {
+                _at = start;
+                fail(ec == std::errc::result_out_of_range ? "Number out of range" : "Expected a number");
+                return 0;
+            }
+            return value;
+        }
+        void skip()
+        {
+            const char c = peek();
+            if (c == '{')
+                object([&](const std::string&) { skip(); });
+            else if (c == '"')
+                string();
+            else if (c == '[')
+            {
+                _at++;
+                while (!failed() && peek() != ']')
+                {
+                    skip();
+                    if (peek() == ',')
+                        _at++;
+                    else if (peek() != ']')
+                        fail("Expected ',' or ']'");
+                }
+                expect(']');
+            }
+            else if (c == '-' || std::isdigit(static_cast<unsigned char>(c)))
+            {
+                while (_at < _text.size() && std::string("-+.eE0123456789").find(_text[_at]) != std::string::npos)
+                    _at++;
+            }
+            else if (_text.compare(_at, 4, "true") == 0 || _text.compare(_at, 4, "null") == 0)
+                _at += 4;
+            else if (_text.compare(_at, 5, "false") == 0)
+                _at += 5;
+            else
+                fail("Unexpected character");
+        }
+
+    private:
+        const std::string& _text;
+        size_t _at = 0;
+        std::string _error;
+
+        char peek()
+        {
+            while (_at < _text.size() && std::isspace(static_cast<unsigned char>(_text[_at])))
+                _at++;
+            return _at < _text.size() ? _text[_at] : '\0';
+        }
+        bool expect(char c)
+        {
+            if (peek() != c)
+            {
+                fail(std::string("Expected '") + c + '\'');
+                return false;
+            }
+            _at++;
+            return true;
+        }
+        void fail(const std::string& message)
+        {
+            if (_error.empty())
+                _error = message + " at offset " + std::to_string(_at) + '.';
+        }
+    };
+
+    bool read(const std::string& path, profile& out, std::string& err)
+    {
+        const std::string text = readFile(path);
+        if (text.empty())
+        {
+            err = "Profile '" + path + "' is empty or does not exist.";
+            return false;
+        }
+        json_reader json(text);
+        json.object([&](const std::string& key)
+        {
+            if (key != "functions")
+                return json.skip();
+            json.object([&](const std::string& name)
+            {
+                function_profile& function = out.functions[name];
+                json.object([&](const std::string& field)
+                {
+                    if (field == "calls")
+                        function.calls = json.integer();
+                    else if (field == "lines")
+                        json.object([&](const std::string& line)
+                        {
+                            const long long count = json.integer();
+                            uint32_t number = 0;
+                            auto [last, ec] = std::from_chars(line.data(), line.data() + line.size(), number);
+                            if (ec == std::errc() && last == line.data() + line.size())
+                                function.lines[number] += count;
+                        });
+                    else
+                        json.skip();
+                });
+            });
+        });
+        if (json.failed())
+        {
+            err = "Could not read profile '" + path + "': " + json.error();
+            return false;
+        }
+        return true;
+    }
+    bool write(const profile& in, const std::string& path, std::string& err)
+    {
+        std::ofstream out(path);
+        if (!out)
+        {
+            err = "Could not write profile to '" + path + "'.";
+            return false;
+        }
+        // sorted, so profiles diff well.
+        std::map<std::string, const function_profile*> functions;
+        for (auto& [name, function] : in.functions)
+            functions[name] = &function;
+
+        out << "{\n  \"functions\": {";
+        bool first = true;
+        for (auto& [name, function] : functions)
+        {
+            out << (first ? "\n" : ",\n") << "    " << util::jsonString(name) << ": {\"calls\": " << function->calls;
+            first = false;
+            if (function->lines.empty())
+            {
+                out << '}';
+                continue;
+            }
+            std::map<uint32_t, long long> lines(function->lines.begin(), function->lines.end());
+            out << ", \"lines\": {";
+            bool firstLine = true;
+            for (auto& [line, count] : lines)
+            {
+                out << (firstLine ? "" : ", ") << '"' << line << "\": " << count;
+                firstLine = false;
+            }
+            out << "}}";
+        }
+        out << "\n  }\n}\n";
+        return out.good();
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+// profile guided optimization: execution counts gathered on a server, fed back into tomc.
+//
+// a profile is a JSON object keyed by redscript function (as in mc_function::source) and source line:
+// {"functions": {"check": {"calls": 1200, "lines": {"18": 1100, "23": 100}}, "<global>": {"calls": 1}}}
+// 'calls' is how often the function ran, and every entry of 'lines' how often the statement starting on
+// that line ran. unknown keys are skipped, so tools can add their own.
+namespace pgo
+{
+    enum class heat
+    {
+        UNKNOWN, // not in the profile, compiled as without one.
+        COLD,    // in the profile, but never ran.
+        WARM,
+        HOT      // ran at least hotPercent percent as often as the hottest count in the profile.
+    };
+    struct function_profile
+    {
+        long long calls = 0;
+        std::unordered_map<uint32_t, long long> lines;
+    };
+    class profile
+    {
+    public:
+        std::unordered_map<std::string, function_profile> functions;
+        // 10 keeps hot to the few counts that dominate the profile, a lower value marks nearly everything that ran.
+        int hotPercent = 10;
+
+        // -1 when the function is not in the profile.
+        long long calls(const std::string& function) const;
+        // 0 for lines of a profiled function that never ran, -1 when the function is not in the profile.
+        long long count(const std::string& function, uint32_t line) const;
+
+        heat of(const std::string& function) const;
+        heat of(const std::string& function, uint32_t line) const;
+
+        // the largest count in the profile, what hotPercent is taken of.
+        long long hottest() const;
+    };
+
+    bool read(const std::string& path, profile& out, std::string& err);
+    bool write(const profile& in, const std::string& path, std::string& err);
+}
@@ -0,0 +1,237 @@
+#include <charconv>
+#include <fstream>
+#include <regex>
+#include <map>
+#include "profile.hpp"
+#include "file.hpp"
+#include "pgo.hpp"
+
+#define PROFILE_COUNTER(kind, id) std::string(kind) + std::to_string(id) + SEP RS_PROFILE_OBJECTIVE
+
+namespace profiling
+{
+    // commands that can end the function they are in, so the commands after them may not run.
+    static bool mayReturn(const mc_command& cmd)
+    {
+        const std::string& body = cmd.body;
+        return body.starts_with("return") || body.starts_with("$return") || body.find(" return ") != std::string::npos;
+    }
+    static std::string label(const mc_program& program, size_t id, const std::string& ns)
+    {
+        if (id == 0)
+            return RS_GLOBAL_SOURCE_NAME;
+        return program.functions.at(id - 1).location(ns);
+    }
+    // counts calls once, and commands once per run of commands that always execute together.
+    static void instrumentFunction(mc_function& function, size_t id)
+    {
+        mccmdlist counted;
+        counted.push_back(mc_command{false, MC_RAW_CMD_ID, "scoreboard players add " + PROFILE_COUNTER("f", id) + " 1"});
+
+        size_t start = 0;
+        while (start < function.commands.size())
+        {
+            size_t end = start;
+            while (end < function.commands.size() && !mayReturn(function.commands.at(end)))
+                end++;
+            // the returning command itself still runs.
+            end = std::min(end + 1, function.commands.size());
+
+            counted.push_back(mc_command{false, MC_RAW_CMD_ID, "scoreboard players add " + PROFILE_COUNTER("c", id) + SEP + std::to_string(end - start)});
+            counted.insert(counted.end(), function.commands.begin() + start, function.commands.begin() + end);
+            start = end;
+        }
+        function.commands = std::move(counted);
+    }
+    void instrument(mc_program& program, const std::string& ns)
+    {
+        const size_t count = program.functions.size() + 1;
+
+        instrumentFunction(program.globalFunction, 0);
+        for (size_t id = 1; id < count; id++)
+            instrumentFunction(program.functions.at(id - 1), id);
+
+        program.globalFunction.commands.insert(program.globalFunction.commands.begin(),
+            mc_command{false, MC_RAW_CMD_ID, "scoreboard objectives add " RS_PROFILE_OBJECTIVE " dummy"});
+
+        mc_function dump;
+        dump.name = "dump";
+        dump.modulePath = {MC_PROFILE_FOLDER};
+        dump.source = RS_GLOBAL_SOURCE_NAME;
+        auto& commands = dump.commands;
+        auto raw = [&](const std::string& body) { commands.push_back(mc_command{false, MC_RAW_CMD_ID, body}); };
+
+        raw("data modify storage " RS_PROFILE_STORAGE " functions set value []");
+        for (size_t id = 0; id < count; id++)
+            raw("data modify storage " RS_PROFILE_STORAGE " functions append value {id:" + std::to_string(id) +
+                ",name:\"" + label(program, id, ns) + "\",calls:0,commands:0}");
+        for (size_t id = 0; id < count; id++)
+        {
+            // an unset counter fails the 'get', which stores 0.
+            const std::string at = "functions[" + std::to_string(id) + "]";
+            raw("execute store result storage " RS_PROFILE_STORAGE SEP + at + ".calls int 1 run scoreboard players get " + PROFILE_COUNTER("f", id));
+            raw("execute store result storage " RS_PROFILE_STORAGE SEP + at + ".commands int 1 run scoreboard players get " + PROFILE_COUNTER("c", id));
+        }
+        raw("tellraw @a {\"text\":\"[redscript] profile (function, calls, commands):\"}");
+        for (size_t id = 0; id < count; id++)
+        {
+            auto score = [&](const char* kind)
+            { return "{\"score\":{\"name\":\"" + std::string(kind) + std::to_string(id) + "\",\"objective\":\"" RS_PROFILE_OBJECTIVE "\"}}"; };
+
+            raw("execute if score " + PROFILE_COUNTER("f", id) + " matches 1.. run tellraw @a [{\"text\":\"" +
+                label(program, id, ns) + " \"}," + score("f") + ",{\"text\":\" \"}," + score("c") + "]");
+        }
+
+        mc_function reset;
+        reset.name = "reset";
+        reset.modulePath = {MC_PROFILE_FOLDER};
+        reset.source = RS_GLOBAL_SOURCE_NAME;
+        reset.commands.push_back(mc_command{false, MC_RAW_CMD_ID, "scoreboard players reset * " RS_PROFILE_OBJECTIVE});
+
+        program.functions.push_back(std::move(dump));
+        program.functions.push_back(std::move(reset));
+    }
+    bool writeMap(const mc_program& program, const std::string& ns, const std::string& path, std::string& err)
+    {
+        std::ofstream out(path);
+        if (!out)
+        {
+            err = "Could not write profile map to '" + path + "'.";
+            return false;
+        }
+        auto line = [](const mc_function& function) -> uint32_t
+        {
+            if (!function.generated)
+                return 0;
+            for (const mc_command& command : function.commands)
+                if (command.origin.line)
+                    return command.origin.line;
+            return 0;
+        };
+        out << 0 << '\t' << label(program, 0, ns) << '\t' << program.globalFunction.source << "\t0\n";
+        for (size_t id = 1; id <= program.functions.size(); id++)
+        {
+            const mc_function& function = program.functions.at(id - 1);
+            if (function.modulePath.size() == 1 && function.modulePath.front() == MC_PROFILE_FOLDER)
+                continue;
+            out << id << '\t' << label(program, id, ns) << '\t' << function.source << '\t' << line(function) << '\n';
+        }
+        return true;
+    }
+    // the whole of text as a number, false if it isn't one or doesn't fit.
+    template<typename _Number>
+    static bool number(const std::string& text, _Number& out)
+    {
+        auto [last, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+        return ec == std::errc() && last == text.data() + text.size();
+    }
+    bool report(const std::string& dumpPath, const std::string& mapPath, const std::string& profilePath, std::string& err)
+    {
+        struct entry
+        {
+            std::string location;
+            std::string source;
+            uint32_t  line     = 0;
+            long long calls    = 0;
+            long long commands = 0;
+        };
+        std::map<size_t, entry> entries;
+
+        std::ifstream map(mapPath);
+        if (!map)
+        {
+            err = "Could not read profile map '" + mapPath + "'. Compile with --profile first.";
+            return false;
+        }
+        std::string line;
+        uint32_t lineNumber = 0;
+        while (std::getline(map, line))
+        {
+            const size_t a = line.find('\t'), b = line.find('\t', a + 1);
+            if (a == std::string::npos || b == std::string::npos)
+                continue;
+            // maps written before lines were added have three columns.
+            const size_t c = line.find('\t', b + 1);
+            size_t id = 0;
+            if (!number(line.substr(0, a), id) || (c != std::string::npos && !number(line.substr(c + 1), lineNumber)))
+            {
+                err = "Malformed line in profile map '" + mapPath + "': '" + line + "'.";
+                return false;
+            }
+            entry& e   = entries[id];
+            e.location = line.substr(a + 1, b - a - 1);
+            e.source   = line.substr(b + 1, c == std::string::npos ? std::string::npos : c - b - 1);
+            e.line     = c == std::string::npos ? 0 : lineNumber;
+        }
+
+        const std::string dump = readFile(dumpPath);
+        if (dump.empty())
+        {
+            err = "Profile dump '" + dumpPath + "' is empty or does not exist.";
+            return false;
+        }
+        static const std::regex counters(R"(id:\s*(\d+)[^}]*?calls:\s*(-?\d+)[^}]*?commands:\s*(-?\d+))");
+        size_t read = 0;
+        for (std::sregex_iterator it(dump.begin(), dump.end(), counters), end; it != end; ++it, read++)
+        {
+            size_t id = 0;
+            long long calls = 0, commands = 0;
+            if (!number((*it)[1], id) || !number((*it)[2], calls) || !number((*it)[3], commands))
+            {
+                err = "Counter out of range in '" + dumpPath + "': '" + it->str() + "'.";
+                return false;
+            }
+            auto found = entries.find(id);
+            if (found == entries.end())
+                continue;
+            found->second.calls    = calls;
+            found->second.commands = commands;
+        }
+        if (read == 0)
+        {
+            err = "No counters found in '" + dumpPath + "'. Expected the output of '/data get storage " RS_PROFILE_STORAGE " functions'.";
+            return false;
+        }
+
+        std::vector<const entry*> ran;
+        std::map<std::string, long long> bySource;
+        long long total = 0;
+        for (auto& [id, e] : entries)
+        {
+            if (e.calls <= 0)
+                continue;
+            ran.push_back(&e);
+            bySource[e.source] += e.commands;
+            total += e.commands;
+        }
+        std::sort(ran.begin(), ran.end(), [](const entry* a, const entry* b) { return a->commands > b->commands; });
+
+        auto percent = [&](long long n) { return total ? 100.0 * n / total : 0.0; };
+
+        printf("%12s %10s %7s  %s\n", "commands", "calls", "%", "function (source)");
+        for (const entry* e : ran)
+            printf("%12lld %10lld %6.2f%%  %s (%s)\n", e->commands, e->calls, percent(e->commands), e->location.c_str(), e->source.c_str());
+
+        std::vector<std::pair<std::string, long long>> sources(bySource.begin(), bySource.end());
+        std::sort(sources.begin(), sources.end(), [](auto& a, auto& b) { return a.second > b.second; });
+
+        printf("\n%12s %7s  %s\n", "commands", "%", "redscript function (including generated functions)");
+        for (auto& [source, commands] : sources)
+            printf("%12lld %6.2f%%  %s\n", commands, percent(commands), source.c_str());
+        printf("\n%12lld total\n", total);
+
+        pgo::profile counts;
+        for (auto& [id, e] : entries)
+        {
+            pgo::function_profile& function = counts.functions[e.source];
+            if (e.line)
+                function.lines[e.line] += e.calls;
+            else
+                function.calls += e.calls;
+        }
+        if (!pgo::write(counts, profilePath, err))
+            return false;
+        printf("Profile for --pgo written to %s.\n", profilePath.c_str());
+        return true;
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+#include "mc.hpp"
+
+// runtime profiling of a compiled program. counters are kept in the RS_PROFILE_OBJECTIVE scoreboard objective,
+// one 'f<id>' (calls) and one 'c<id>' (commands run) holder per function. id 0 is the global function, and id n
+// is program.functions[n - 1].
+namespace profiling
+{
+    // adds the counters to every function, then adds the '_profile/dump' and '_profile/reset' functions.
+    // must run last, after every pass that adds or changes commands.
+    void instrument(mc_program& program, const std::string& ns);
+
+    // writes one line per counter id: '<id>\t<location>\t<source>\t<line>', so a dump can be read back offline.
+    // line is the source line a generated function starts on, and 0 for functions the user declared.
+    bool writeMap(const mc_program& program, const std::string& ns, const std::string& path, std::string& err);
+
+    // reads the output of '/data get storage redscript:_profile functions' and the map written at compile time,
+    // and prints the functions by commands run. also writes the counts as a pgo profile to profilePath:
+    // calls of declared functions, and calls of generated ones (branch and loop bodies) as counts of their line.
+    bool report(const std::string& dumpPath, const std::string& mapPath, const std::string& profilePath, std::string& err);
+}
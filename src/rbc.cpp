@@ -3,8 +3,14 @@
 #include "lexer.hpp"
 #include "file.hpp"
 #include "mchelpers.hpp"
+#include "opt.hpp"
+#include "context.hpp"
 
 #include <regex>
+#include <set>
+#include <map>
+#include <cmath>
+#include <numbers>
 
 namespace rbc_commands
 {
@@ -38,6 +44,32 @@ namespace rbc_commands
         {
             return rbc_command(rbc_instruction::CREATE, rbc_value(var));
         }
+        rbc_command cast(std::shared_ptr<rs_variable> var, std::shared_ptr<rs_object> type, std::shared_ptr<rs_variable> from)
+        {
+            if (from)
+                return rbc_command(rbc_instruction::CAST, rbc_value(var), rbc_value(type), rbc_value(from));
+            return rbc_command(rbc_instruction::CAST, rbc_value(var), rbc_value(type));
+        }
+        rbc_command index(std::shared_ptr<rs_variable> var, std::shared_ptr<rs_variable> list, rbc_value index)
+        {
+            return rbc_command(rbc_instruction::INDEX, rbc_value(var), rbc_value(list), index);
+        }
+        rbc_command setIndex(std::shared_ptr<rs_variable> list, rbc_value index, rbc_value val)
+        {
+            return rbc_command(rbc_instruction::SETINDEX, rbc_value(list), index, val);
+        }
+        rbc_command hasKey(std::shared_ptr<rs_variable> var, std::shared_ptr<rs_variable> map, rbc_value key)
+        {
+            return rbc_command(rbc_instruction::HASKEY, rbc_value(var), rbc_value(map), key);
+        }
+        rbc_command removeKey(std::shared_ptr<rs_variable> map, rbc_value key)
+        {
+            return rbc_command(rbc_instruction::DELKEY, rbc_value(map), key);
+        }
+        rbc_command removeKey(std::shared_ptr<rs_variable> map)
+        {
+            return rbc_command(rbc_instruction::DELKEY, rbc_value(map));
+        }
     }
 }
 
@@ -50,14 +82,36 @@ rbc_function_decorator parseDecorator(const std::string& name)
     if (name == "__single__")  return rbc_function_decorator::SINGLE;
     if (name == "__cpp__") return rbc_function_decorator::CPP;
     if (name == "__nocompile__") return rbc_function_decorator::NOCOMPILE;
+    if (name == "async") return rbc_function_decorator::ASYNC;
+    if (name == "budget") return rbc_function_decorator::BUDGET;
     return rbc_function_decorator::UNKNOWN;
 }
 
 #pragma endregion decorators
+#pragma region tables
+// what generate() can tabulate. trig functions take degrees, like rotations in minecraft.
+static const std::unordered_map<std::string, double(*)(double)> TABLE_GENERATORS =
+{
+    {"sin",   [](double x) { return std::sin(x * std::numbers::pi / 180); }},
+    {"cos",   [](double x) { return std::cos(x * std::numbers::pi / 180); }},
+    {"tan",   [](double x) { return std::tan(x * std::numbers::pi / 180); }},
+    {"sqrt",  [](double x) { return std::sqrt(x); }},
+    {"cbrt",  [](double x) { return std::cbrt(x); }},
+    {"exp",   [](double x) { return std::exp(x); }},
+    {"log",   [](double x) { return std::log(x); }},
+    {"log2",  [](double x) { return std::log2(x); }},
+    {"log10", [](double x) { return std::log10(x); }}
+};
+// tables are written as one command, this keeps it a reasonable size.
+#define RS_TABLE_MAX_ENTRIES 65536
+#pragma endregion tables
 #pragma region operators
 
 void rbc_program::operator()(std::vector<rbc_command>& instructions)
 {
+    for (rbc_command& instruction : instructions)
+        if (!instruction.origin.line)
+            instruction.origin = origin;
     if (currentFunction)
     {
         std::vector<rbc_command>& toAppend = currentFunction->instructions;
@@ -69,8 +123,10 @@ void rbc_program::operator()(std::vector<rbc_command>& instructions)
 }
 void rbc_program::operator ()(const rbc_command& instruction)
 {
-    if (currentFunction) currentFunction->instructions.push_back(instruction);
-    else globalFunction.instructions.push_back(instruction);
+    std::vector<rbc_command>& instructions = currentFunction ? currentFunction->instructions : globalFunction.instructions;
+    instructions.push_back(instruction);
+    if (!instructions.back().origin.line)
+        instructions.back().origin = origin;
 }
 
 #pragma endregion operators
@@ -225,6 +281,42 @@ std::string rbc_command::toHumanStr()
         case rbc_instruction::POP:
             stream << "POP ";
             break;
+        case rbc_instruction::LOOP:
+            stream << "LOOP";
+            break;
+        case rbc_instruction::WHILE:
+            stream << "WHILE ";
+            break;
+        case rbc_instruction::FOR:
+            stream << "FOR ";
+            break;
+        case rbc_instruction::ENDLOOP:
+            stream << "ENDLOOP";
+            break;
+        case rbc_instruction::BREAK:
+            stream << "BREAK";
+            break;
+        case rbc_instruction::CONTINUE:
+            stream << "CONTINUE";
+            break;
+        case rbc_instruction::YIELD:
+            stream << "YIELD ";
+            break;
+        case rbc_instruction::CAST:
+            stream << "CAST ";
+            break;
+        case rbc_instruction::INDEX:
+            stream << "INDEX ";
+            break;
+        case rbc_instruction::SETINDEX:
+            stream << "SETINDEX ";
+            break;
+        case rbc_instruction::HASKEY:
+            stream << "HASKEY ";
+            break;
+        case rbc_instruction::DELKEY:
+            stream << "DELKEY ";
+            break;
         default:
             stream << "UNKNOWN ";
             break;
@@ -310,13 +402,13 @@ sharedt<rbc_register> rbc_program::makeRegister(bool operable, bool vacant)
 
 #define COMP_ERROR(_ec, message, ...)                                    \
     {                                                                    \
-        *err = rs_error(message, content, current->trace, fName, current->trace.start, ##__VA_ARGS__);  \
+        *err = rs_error(message, content, current->trace, fName, ##__VA_ARGS__);  \
         err->trace.ec = _ec;                                                  \
         return program;                                                   \
     }
 #define COMP_ERROR_R(_ec, message, ret, ...)                                    \
     {                                                                    \
-        *err = rs_error(message, content, current->trace, fName, current->trace.start, ##__VA_ARGS__);  \
+        *err = rs_error(message, content, current->trace, fName, ##__VA_ARGS__);  \
         err->trace.ec = _ec;                                                  \
         return ret;                                                   \
     }
@@ -327,7 +419,11 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
     size_t _At = 0;
 #pragma region global_flags
     bool _flag_parsingelif = false;
+    bool _flag_parsingwhile = false;
+    int  _loopDepth = 0;
 #pragma endregion
+    // holds computed list indexes, see 'list[index] = value;'.
+    std::shared_ptr<rbc_register> indexRegister = nullptr;
     // overriding if not set.
     err->trace.at = std::make_shared<size_t>(_At);
     err->content  = std::make_shared<std::string>(content);
@@ -438,7 +534,7 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
                             error = "Evaluated type of this expression is not allowed here.";
                     }
                     COMP_ERROR_R(RS_SYNTAX_ERROR, error, false);
-                } else COMP_ERROR_R(RS_UNSUPPORTED_OPERATION_ERROR, "Non-operable registers arent supported for typing.", false);
+                } else if (!reg.operable) COMP_ERROR_R(RS_UNSUPPORTED_OPERATION_ERROR, "Non-operable registers arent supported for typing.", false);
 
                 break;
             }
@@ -504,7 +600,9 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
         return true;
     };
 #pragma region variables
-    auto typeparse = [&]() -> rs_type_info
+    // a std::function, the value type of a map is parsed by calling it again.
+    std::function<rs_type_info()> typeparse;
+    typeparse = [&]() -> rs_type_info
     {
 
         rs_type_info tinfo;
@@ -516,6 +614,22 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
 
 
         int typeID = next->info;
+        std::vector<rs_type_info> mapped;
+        // map<string, T>, only strings are keys.
+        if (next->type == token_type::TYPE_DEF && typeID == RS_MAP_KW_ID)
+        {
+            if (!(next = adv()) || next->info != '<')
+                COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected '<' after map.", tinfo);
+            if (!(next = adv()) || next->type != token_type::TYPE_DEF || next->info != RS_STRING_KW_ID)
+                COMP_ERROR_R(RS_SYNTAX_ERROR, "Map keys must be of type string.", tinfo);
+            if (!(next = adv()) || next->info != ',')
+                COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected ',' after the key type of a map.", tinfo);
+            mapped.push_back(typeparse());
+            if (err->trace.ec)
+                return tinfo;
+            if (current->info != '>')
+                COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected '>' to close the map type.", tinfo);
+        }
 
         // its not any kw
         if(typeID == 0 && next->type != token_type::TYPE_DEF)
@@ -556,9 +670,10 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
             tinfo.strict = strict;
             tinfo.optional = optional;
             tinfo.array_count = arrayCount;
+            tinfo.mapped = mapped;
         }
         else
-            tinfo.otherTypes.push_back(rs_type_info{typeID, arrayCount, optional, strict});
+            tinfo.otherTypes.push_back(rs_type_info{typeID, arrayCount, optional, strict, {}, mapped});
         if(!adv())
             COMP_ERROR_R(RS_SYNTAX_ERROR, "Missing semicolon.", tinfo);
 
@@ -567,6 +682,145 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
             COMP_ERROR_R(RS_SYNTAX_ERROR, "Invalid type notation.", tinfo);
         return tinfo;
     };
+    // map keys are written between quotes in storage paths and pasted there by macros, a string literal key
+    // can't have the quotes or backslashes that would need escaping.
+    auto keyverify = [&](const rbc_value& key) -> bool
+    {
+        if (key.index() == 0 && std::get<0>(key).val.find('\\') != std::string::npos)
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "Map keys can't contain '\"' or '\\'.", false);
+        return true;
+    };
+    // must be called at the index of the open square bracket of 'list[index]', leaves current at the closing one.
+    // a map is indexed by its key, 'map[key]'.
+    auto indexparse = [&](rs_variable& list) -> std::shared_ptr<rbc_value>
+    {
+        const bool map = list.type_info.isMap();
+        if (!list.type_info.array_count && !map)
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "'{}' is not a list and cannot be indexed.", nullptr, list.name);
+        size_t close = _At;
+        for (int depth = 0; close < S; close++)
+        {
+            const token_type t = tokens.at(close).type;
+            if (t == token_type::SQBRACKET_OPEN)
+                depth++;
+            else if (t == token_type::SQBRACKET_CLOSED && --depth == 0)
+                break;
+        }
+        if (close >= S)
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "Unclosed square bracket.", nullptr);
+        if (close == _At + 1)
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected index.", nullptr);
+        adv();
+        rs_expression expr = expreval(program, tokens, _At, err, false, false);
+        if (err->trace.ec)
+            return nullptr;
+        if (expr.nonOperationalResult)
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "{} must be {}.", nullptr, map ? "Map key" : "List index", map ? "a string" : "an integer");
+        rbc_value index = expr.rbc_evaluate(program, err);
+        if (err->trace.ec)
+            return nullptr;
+        rs_type_info type{map ? RS_STRING_KW_ID : RS_INT_KW_ID};
+        if (!typeverify(type, index, 2) || (map && !keyverify(index)))
+            return nullptr;
+        _At = close;
+        resync();
+        return std::make_shared<rbc_value>(index);
+    };
+    // has(map, key) and remove(map, key), unless a function of that name exists. must be called at the index
+    // of the open bracket, leaves current at the closing one. the key is a string literal or variable.
+    auto keyedparse = [&](std::shared_ptr<rs_variable>& map) -> std::shared_ptr<rbc_value>
+    {
+        if (!adv() || current->type != token_type::WORD || !(map = program.getVariable(current->repr)))
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected a map variable.", nullptr);
+        if (!map->type_info.isMap())
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "'{}' is not a map.", nullptr, map->name);
+        if (!adv() || current->info != ',')
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected ',' after the map.", nullptr);
+        if (!adv())
+            COMP_ERROR_R(RS_EOF_ERROR, "Expected key, not EOF.", nullptr);
+        std::shared_ptr<rbc_value> key = nullptr;
+        if (current->type == token_type::STRING_LITERAL)
+        {
+            key = std::make_shared<rbc_value>(rbc_constant(current->type, current->repr, &current->trace));
+            if (!keyverify(*key))
+                return nullptr;
+        }
+        else if (current->type == token_type::WORD)
+        {
+            std::shared_ptr<rs_variable> var = program.getVariable(current->repr);
+            if (!var)
+                COMP_ERROR_R(RS_SYNTAX_ERROR, "Unknown variable '{}'.", nullptr, current->repr);
+            if (!var->type_info.equals(RS_STRING_KW_ID))
+                COMP_ERROR_R(RS_SYNTAX_ERROR, "Map key must be a string.", nullptr);
+            key = std::make_shared<rbc_value>(var);
+        }
+        else
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "Map key must be a string or a variable.", nullptr);
+        if (!adv() || current->type != token_type::BRACKET_CLOSED)
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected ')'.", nullptr);
+        return key;
+    };
+    auto isKeyed = [&](const std::string& name, const char* keyed)
+    { return name == keyed && program.functions.find(name) == program.functions.end(); };
+    // generate(f, from..to, scale), the list of round(f(x) * scale) for every int x from 'from' up to 'to'. it
+    // is computed here, so reading the table is one index. must be called at the index of the open bracket,
+    // leaves current at the closing one.
+    auto tableparse = [&]() -> std::shared_ptr<rs_list>
+    {
+        if (!adv() || current->type != token_type::WORD)
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected the function to tabulate.", nullptr);
+        auto generator = TABLE_GENERATORS.find(current->repr);
+        if (generator == TABLE_GENERATORS.end())
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "generate() takes sin, cos, tan, sqrt, cbrt, exp, log, log2 or log10.", nullptr);
+        if (!adv() || current->info != ',')
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected ',' after the function.", nullptr);
+        // int literals, with a sign.
+        auto literal = [&](long long& out) -> bool
+        {
+            if (!adv())
+                COMP_ERROR_R(RS_EOF_ERROR, "Expected integer, not EOF.", false);
+            const bool negative = current->type == token_type::OPERATOR && current->repr == "-";
+            if (negative && !adv())
+                COMP_ERROR_R(RS_EOF_ERROR, "Expected integer, not EOF.", false);
+            if (current->type != token_type::INT_LITERAL)
+                COMP_ERROR_R(RS_SYNTAX_ERROR, "Table bounds and scale must be integer literals.", false);
+            out = std::stoll(current->repr) * (negative ? -1 : 1);
+            return true;
+        };
+        long long from = 0, to = 0, scale = 1;
+        if (!literal(from))
+            return nullptr;
+        if (!adv() || current->type != token_type::RANGE)
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected range ('..').", nullptr);
+        if (!literal(to))
+            return nullptr;
+        if (to <= from || to - from > RS_TABLE_MAX_ENTRIES)
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "A table needs between 1 and 65536 entries.", nullptr);
+        if (!adv())
+            COMP_ERROR_R(RS_EOF_ERROR, "Expected ')', not EOF.", nullptr);
+        if (current->info == ',')
+        {
+            if (!literal(scale))
+                return nullptr;
+            if (!adv())
+                COMP_ERROR_R(RS_EOF_ERROR, "Expected ')', not EOF.", nullptr);
+        }
+        if (current->type != token_type::BRACKET_CLOSED)
+            COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected ')'.", nullptr);
+
+        std::shared_ptr<rs_list> table = std::make_shared<rs_list>();
+        table->elementType = rs_type_info{RS_INT_KW_ID};
+        for (long long x = from; x < to; x++)
+        {
+            const double value = std::round(generator->second(static_cast<double>(x)) * scale);
+            if (!std::isfinite(value))
+                COMP_ERROR_R(RS_SYNTAX_ERROR, "{}({}) is not a finite number, it can't be in a table.", nullptr, generator->first, x);
+            // scores are 32 bit, tan(90) and the like are clamped.
+            const long long clamped = std::clamp<double>(value, INT32_MIN, INT32_MAX);
+            table->values.push_back(std::make_shared<rbc_value>(rbc_constant(token_type::INT_LITERAL, std::to_string(clamped))));
+        }
+        return table;
+    };
     // forward decl
     std::function<bool(std::string&, bool, std::shared_ptr<rs_module>)> callparse;
     // must be called at the index of the token after the variable name, ie myVar:int, at the colon.
@@ -618,6 +872,118 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
             if(!adv())
                 COMP_ERROR_R(RS_EOF_ERROR, "Expected expression, not EOF.", nullptr);
             token* next = nullptr;
+            // a cast, '(type) variable' or '(type) call()', keeps only the members the object type declares.
+            if (current->type == token_type::BRACKET_OPEN && (next = peek()) && next->type == token_type::WORD
+             && program.objectTypes.count(next->repr) && (next = peek(2)) && next->type == token_type::BRACKET_CLOSED)
+            {
+                std::shared_ptr<rs_object> type = program.objectTypes.at(peek()->repr);
+                auto isObject = [](rs_type_info& t)
+                { return !t.array_count && (t.type_id == RS_OBJECT_KW_ID || t.type_id >= static_cast<int32_t>(rs_object::TYPE_CARET_START)); };
+
+                if (variable->type_info.array_count || (variable->type_info.type_id != type->typeID && variable->type_info.type_id != RS_OBJECT_KW_ID))
+                    COMP_ERROR_R(RS_SYNTAX_ERROR, "Cannot assign a cast to '{}' to a variable of a different type.", nullptr, type->name);
+                for (auto& [memberName, member] : type->members)
+                    if (member.first.value && memberDefault(member).empty())
+                        COMP_ERROR_R(RS_SYNTAX_ERROR, "Member '{}' of '{}' must default to a literal to be cast to.", nullptr, memberName, type->name);
+                if (!adv(3))
+                    COMP_ERROR_R(RS_EOF_ERROR, "Expected expression, not EOF.", nullptr);
+                if (current->type != token_type::WORD)
+                    COMP_ERROR_R(RS_SYNTAX_ERROR, "Only variables and function calls can be cast.", nullptr);
+
+                std::shared_ptr<rs_variable> from = nullptr;
+                if ((next = peek()) && next->type == token_type::BRACKET_OPEN)
+                {
+                    std::string& funcname = current->repr;
+                    auto f = program.functions.find(funcname);
+                    if (f != program.functions.end() && !isObject(*f->second->returnType))
+                        COMP_ERROR_R(RS_SYNTAX_ERROR, "Only objects can be cast, '{}' does not return one.", nullptr, funcname);
+                    adv();
+                    if (!callparse(funcname, false, nullptr))
+                        return nullptr;
+                }
+                else
+                {
+                    if (!(from = program.getVariable(current->repr)))
+                        COMP_ERROR_R(RS_SYNTAX_ERROR, "Unknown variable '{}'.", nullptr, current->repr);
+                    if (!isObject(from->type_info))
+                        COMP_ERROR_R(RS_SYNTAX_ERROR, "Only objects can be cast, '{}' is not one.", nullptr, from->name);
+                }
+
+                if (!adv() || current->type != token_type::LINE_END)
+                    COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected semi-colon to end expression.", nullptr);
+                if (needsCreation)
+                    program(rbc_commands::variables::create(variable));
+
+                program(rbc_commands::variables::cast(variable, type, from));
+                break;
+            }
+            if (current->type == token_type::WORD && (next = peek()) && next->type == token_type::SQBRACKET_OPEN && !obj)
+            {
+                // an element of a list, 'list[index]'. like a call, it is the whole expression.
+                std::shared_ptr<rs_variable> list = program.getVariable(current->repr);
+                if (!list)
+                    COMP_ERROR_R(RS_SYNTAX_ERROR, "Unknown variable '{}'.", nullptr, current->repr);
+                if (!list->type_info.element_type().equals(variable->type_info))
+                    COMP_ERROR_R(RS_SYNTAX_ERROR, "Cannot assign an element of '{}' to a variable of a different type.", nullptr, list->name);
+                adv();
+                std::shared_ptr<rbc_value> index = indexparse(*list);
+                if (!index)
+                    return nullptr;
+                if (!adv() || current->type != token_type::LINE_END)
+                    COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected semi-colon to end expression. List elements are not allowed in arithmetic expressions.", nullptr);
+                if (needsCreation)
+                    program(rbc_commands::variables::create(variable));
+
+                program(rbc_commands::variables::index(variable, list, *index));
+                break;
+            }
+            if (variable->type_info.isMap() && current->type == token_type::CBRACKET_OPEN)
+            {
+                // a map starts empty, assigning '{}' clears it. entries are set with 'map[key] = value'.
+                if (!adv() || current->type != token_type::CBRACKET_CLOSED)
+                    COMP_ERROR_R(RS_SYNTAX_ERROR, "Only an empty map can be assigned to a map, set entries with 'map[key] = value'.", nullptr);
+                if (!adv() || current->type != token_type::LINE_END)
+                    COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected semi-colon to end expression.", nullptr);
+                if (needsCreation)
+                    program(rbc_commands::variables::create(variable));
+                else
+                    program(rbc_commands::variables::removeKey(variable));
+                break;
+            }
+            if (current->type == token_type::WORD && isKeyed(current->repr, "generate") && (next = peek()) && next->type == token_type::BRACKET_OPEN)
+            {
+                if (!needsCreation)
+                    COMP_ERROR_R(RS_SYNTAX_ERROR, "generate() can only initialize a new variable.", nullptr);
+                if (variable->type_info.type_id != RS_INT_KW_ID || variable->type_info.array_count != 1)
+                    COMP_ERROR_R(RS_SYNTAX_ERROR, "generate() makes an int[].", nullptr);
+                adv();
+                std::shared_ptr<rs_list> table = tableparse();
+                if (!table)
+                    return nullptr;
+                if (!adv() || current->type != token_type::LINE_END)
+                    COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected semi-colon to end expression.", nullptr);
+
+                program(rbc_commands::variables::create(variable, table));
+                break;
+            }
+            if (current->type == token_type::WORD && isKeyed(current->repr, "has") && (next = peek()) && next->type == token_type::BRACKET_OPEN)
+            {
+                // has(map, key) is 1 if the map has the key, 0 otherwise.
+                if (!variable->type_info.equals(RS_INT_KW_ID))
+                    COMP_ERROR_R(RS_SYNTAX_ERROR, "has() is an int, '{}' is not.", nullptr, variable->name);
+                adv();
+                std::shared_ptr<rs_variable> map = nullptr;
+                std::shared_ptr<rbc_value> key = keyedparse(map);
+                if (!key)
+                    return nullptr;
+                if (!adv() || current->type != token_type::LINE_END)
+                    COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected semi-colon to end expression. has() is not allowed in arithmetic expressions.", nullptr);
+                if (needsCreation)
+                    program(rbc_commands::variables::create(variable));
+
+                program(rbc_commands::variables::hasKey(variable, map, *key));
+                break;
+            }
             if (current->type == token_type::WORD && (next = peek()) && next->type == token_type::BRACKET_OPEN)
             {
                 // its a function call, function calls are expensive and only allowed once in an expression,
@@ -684,6 +1050,9 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
         }
         case ';':
             // COMP_ERROR_R(RS_SYNTAX_ERROR, "Cannot redefine variable, remove the type to give the variable a new value.", variable);
+            // a declared map is usable right away, empty.
+            if (!exists && variable && !obj && variable->type_info.isMap())
+                program(rbc_commands::variables::create(variable));
             break;
         case ',':
             if (parameter) break;
@@ -752,6 +1121,9 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
         if (std::find(decorators.begin(), decorators.end(), rbc_function_decorator::CPP) != decorators.end())
             internal = true;
 
+        // an inbuilt reads its arguments where they are when it is called, so the registers holding them stay
+        // taken until then, or the next argument would be computed into the same one.
+        std::vector<sharedt<rbc_register>> held;
         adv();
         if (current->type != token_type::BRACKET_CLOSED)
         {
@@ -768,6 +1140,9 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
                     return false;
 
                 rs_variable* param = function->getNthParameter(pc);
+                // extra arguments of a variadic inbuilt are pushed as its first parameter, only their order matters.
+                if (!param && internal && inb_impls::INB_VARIADIC.count(function->name))
+                    param = function->getNthParameter(0);
                 if (!param)
                     COMP_ERROR_R(RS_SYNTAX_ERROR, "No matching function call with pc of {}", false, pc);
 
@@ -779,6 +1154,11 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
                     c.parameters.push_back(std::make_shared<rbc_value>(fromModule));
                 }
                 program(c);
+                if (internal && result.index() == 1)
+                {
+                    held.push_back(std::get<1>(result));
+                    held.back()->vacant = false;
+                }
                 pc ++;
                 if (current->info == ',')
                     adv();
@@ -802,7 +1182,7 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
             if (var.second.second)
                 actualpc ++;
         }
-        if (actualpc != pc)
+        if (actualpc != pc && !(pc > actualpc && internal && inb_impls::INB_VARIADIC.count(function->name)))
             COMP_ERROR_R(RS_SYNTAX_ERROR, "No matching function call with pc of {}", false, pc);
         rbc_command c(rbc_instruction::CALL);
 
@@ -818,6 +1198,8 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
             c.parameters.push_back(std::make_shared<rbc_value>(rbc_value(fromModule)));
         
         program(c);
+        for (auto& reg : held)
+            reg->free();
         if (!internal)
             for(int i = 0; i < pc; i++)
                 program(rbc_command(rbc_instruction::POP));
@@ -859,9 +1241,10 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
         if (current->type != token_type::CBRACKET_OPEN)
             COMP_ERROR_R(RS_SYNTAX_ERROR, "Expected object body.", nullptr);
         rs_object obj{name, program.currentScope};
-        rs_object_member_decorator decorator = rs_object_member_decorator::OPTIONAL;
         while(adv() && current->type != token_type::CBRACKET_CLOSED)
         {
+            // members without a decorator are optional.
+            rs_object_member_decorator decorator = rs_object_member_decorator::OPTIONAL;
             // dont append to global scope
             token* name;
             token_type& t = current->type;
@@ -940,6 +1323,11 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
 #pragma endregion objects
     do
     {
+        // instructions point at the first token of their statement, not at the token its parser stopped on.
+        const token* previous = _At ? &tokens.at(_At - 1) : nullptr;
+        if (!previous || previous->type == token_type::LINE_END || previous->type == token_type::CBRACKET_OPEN ||
+            previous->type == token_type::CBRACKET_CLOSED || current->type == token_type::CBRACKET_CLOSED)
+            program.origin = {current->trace.file, static_cast<uint32_t>(current->trace.line), static_cast<uint32_t>(current->trace.caret)};
         switch(current->type)
         {
         case token_type::WORD:
@@ -960,8 +1348,54 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
             }
             else if (follows(token_type::BRACKET_OPEN))
             {
-                if(!callparse(word.repr, true, nullptr))
+                if (isKeyed(word.repr, "remove"))
+                {
+                    std::shared_ptr<rs_variable> map = nullptr;
+                    std::shared_ptr<rbc_value> key = keyedparse(map);
+                    if (!key)
+                        return program;
+                    if (!adv() || current->type != token_type::LINE_END)
+                        COMP_ERROR(RS_SYNTAX_ERROR, "Expected semi-colon to end expression.");
+                    program(rbc_commands::variables::removeKey(map, *key));
+                }
+                else if(!callparse(word.repr, true, nullptr))
+                    return program;
+            }
+            else if (follows(token_type::SQBRACKET_OPEN))
+            {
+                // list[index] = value;
+                std::shared_ptr<rs_variable> list = program.getVariable(word.repr);
+                if (!list)
+                    COMP_ERROR(RS_SYNTAX_ERROR, "Unknown variable '{}'.", word.repr);
+                std::shared_ptr<rbc_value> index = indexparse(*list);
+                if (!index)
+                    return program;
+                if (!adv() || current->type != token_type::SYMBOL || current->info != '=')
+                    COMP_ERROR(RS_SYNTAX_ERROR, "Expected '=' after list index.");
+                if (!adv())
+                    COMP_ERROR(RS_EOF_ERROR, "Expected expression, not EOF.");
+                rs_expression expr = expreval(program, tokens, _At, err);
+                if (err->trace.ec)
+                    return program;
+                resync();
+                if (expr.nonOperationalResult)
+                    COMP_ERROR(RS_UNSUPPORTED_OPERATION_ERROR, "Only values can be assigned to a list element.");
+                // the index is read after the value is computed. tomc frees a register once it is operated on,
+                // so a computed index is moved to a register nothing else is given.
+                if (index->index() == 1 && !expr.operation.isSingular())
+                {
+                    if (!indexRegister)
+                        indexRegister = program.makeRegister(true, false);
+                    program(rbc_commands::registers::occupy(indexRegister, *index));
+                    *index = indexRegister;
+                }
+                rbc_value value = expr.rbc_evaluate(program, err);
+                if (err->trace.ec)
+                    return program;
+                rs_type_info element = list->type_info.element_type();
+                if (!typeverify(element, value, 0))
                     return program;
+                program(rbc_commands::variables::setIndex(list, *index, value));
             }
             else if (follows(token_type::MODULE_ACCESS))
             {
@@ -984,6 +1418,14 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
             }
             break;
         }
+        // read by the declaration after it, in the WORD case.
+        case token_type::KW_CONST:
+        {
+            token* next = peek();
+            if (!next || next->type != token_type::WORD || !(next = peek(2)) || next->type != token_type::SYMBOL)
+                COMP_ERROR(RS_SYNTAX_ERROR, "Expected a variable declaration after 'const'.");
+            break;
+        }
         case token_type::KW_MODULE:
         {
             if(!adv())
@@ -994,17 +1436,20 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
             std::vector<std::string> modulePath;
             if (program.currentModule)
             {
-                auto& functions = program.currentModule->functions;
-                if (functions.find(name) != functions.end())
+                auto& children = program.currentModule->children;
+                if (children.find(name) != children.end())
                     COMP_ERROR(RS_SYNTAX_ERROR, "Module already exists with that name.");
                 modulePath = program.currentModule->modulePath;
                 program.moduleStack.push(program.currentModule);
+                // added to the parent's children when closed.
+                program.currentModule = std::make_shared<rs_module>();
+            }
+            else
+            {
+                if(program.modules.find(name) != program.modules.end())
+                    COMP_ERROR(RS_SYNTAX_ERROR, "Module already exists with that name.");
+                program.currentModule = program.modules.insert({name, std::make_shared<rs_module>()}).first->second;
             }
-            else if(program.modules.find(name) != program.modules.end())
-                COMP_ERROR(RS_SYNTAX_ERROR, "Module already exists with that name.");
-
-            auto val = program.modules.insert({name, std::make_shared<rs_module>()});
-            program.currentModule = val.first->second;
             program.currentModule->name = name;
 
             modulePath.push_back(name);
@@ -1118,6 +1563,18 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
                 if (std::find(decorators.begin(), decorators.end(), decorator) != decorators.end())
                     COMP_ERROR(RS_SYNTAX_ERROR, "Duplicate function decorator: '{}'.", dName);
 
+                if (decorator == rbc_function_decorator::ASYNC && !program.currentFunction->returnType->equals(RS_VOID_KW_ID))
+                    COMP_ERROR(RS_SYNTAX_ERROR, "Async functions return to their caller at the first yield, and must return void.");
+
+                if (decorator == rbc_function_decorator::BUDGET)
+                {
+                    if (!adv() || current->type != token_type::BRACKET_OPEN || !adv() || current->type != token_type::INT_LITERAL)
+                        COMP_ERROR(RS_SYNTAX_ERROR, "Expected a command count: budget(<commands>).");
+                    program.currentFunction->budget = std::stoi(current->repr);
+                    if (!adv() || current->type != token_type::BRACKET_CLOSED)
+                        COMP_ERROR(RS_SYNTAX_ERROR, "Expected ')' after budget.");
+                }
+
                 decorators.push_back(decorator);
             }
             if(_At >= S)
@@ -1211,6 +1668,12 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
                     program(rbc_command(rbc_instruction::ENDIF));
                     break;
                 }
+                case rbc_scope_type::LOOP:
+                {
+                    _loopDepth--;
+                    program(rbc_command(rbc_instruction::ENDLOOP));
+                    break;
+                }
                 case rbc_scope_type::NONE:
                 {
                     program(rbc_command(rbc_instruction::DEC));
@@ -1234,6 +1697,9 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
         {
             if (!program.currentFunction)
                 COMP_ERROR(RS_SYNTAX_ERROR, "Return statements can only exist inside a function.");
+            // loop bodies are functions of their own, a return would only leave the current iteration.
+            if (_loopDepth > 0)
+                COMP_ERROR(RS_UNSUPPORTED_OPERATION_ERROR, "Return statements inside loops are not supported yet.");
             
             if (!adv())
                 COMP_ERROR(RS_SYNTAX_ERROR, "Expected expression.");
@@ -1290,7 +1756,7 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
 
             if (current->type == token_type::BRACKET_CLOSED)
             {
-                program(rbc_command(_flag_parsingelif ? rbc_instruction::ELIF : rbc_instruction::IF, lVal));
+                program(rbc_command(_flag_parsingwhile ? rbc_instruction::WHILE : _flag_parsingelif ? rbc_instruction::ELIF : rbc_instruction::IF, lVal));
             end_if_parse:
                 if (!adv())
                     COMP_ERROR(RS_EOF_ERROR, "Unexpected EOF.");
@@ -1299,7 +1765,15 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
                     COMP_ERROR(RS_SYNTAX_ERROR, "Unexpected token.");
                 
                 program.currentScope++;
-                program.scopeStack.push(_flag_parsingelif ? rbc_scope_type::ELIF : rbc_scope_type::IF);
+                if (_flag_parsingwhile)
+                {
+                    program.scopeStack.push(rbc_scope_type::LOOP);
+                    _loopDepth++;
+                }
+                else
+                    program.scopeStack.push(_flag_parsingelif ? rbc_scope_type::ELIF : rbc_scope_type::IF);
+                _flag_parsingelif = false;
+                _flag_parsingwhile = false;
                 break;
             }
 
@@ -1335,7 +1809,8 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
                     COMP_ERROR(RS_SYNTAX_ERROR, "Unexpected token.");
 
             }
-            program(rbc_command(_flag_parsingelif ? rbc_instruction::ELIF : rbc_instruction::IF, lVal, rbc_constant(compop, op.repr, &op.trace), rVal));
+            program(rbc_command(_flag_parsingwhile ? rbc_instruction::WHILE : _flag_parsingelif ? rbc_instruction::ELIF : rbc_instruction::IF,
+                                lVal, rbc_constant(compop, op.repr, &op.trace), rVal));
             
             goto end_if_parse;
         }
@@ -1347,6 +1822,194 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
             _flag_parsingelif = true;
             goto _parseif;
         }
+        case token_type::KW_WHILE:
+        {
+            // the condition is parsed like an if, its computation ends up between LOOP and WHILE
+            // so it can be redone every iteration.
+            program(rbc_command(rbc_instruction::LOOP));
+            _flag_parsingwhile = true;
+            goto _parseif;
+        }
+        case token_type::KW_FOR:
+        {
+            if (!adv() || current->type != token_type::BRACKET_OPEN)
+                COMP_ERROR(RS_SYNTAX_ERROR, "Expected '('.");
+            if (!adv() || current->type != token_type::WORD)
+                COMP_ERROR(RS_SYNTAX_ERROR, "Expected loop variable.");
+
+            token& name = *current;
+            std::shared_ptr<rs_variable> variable = program.getVariable(name.repr);
+            const bool exists = (bool)variable;
+            if (!adv())
+                COMP_ERROR(RS_EOF_ERROR, "Unexpected EOF.");
+            // for (e in @e[type=zombie]): the body runs as and at every entity the selector finds.
+            token* selector = nullptr;
+            if (current->type == token_type::KW_IN && (selector = peek()) && selector->type == token_type::SELECTOR_LITERAL)
+            {
+                if (exists)
+                    COMP_ERROR(RS_SYNTAX_ERROR, "'{}' already exists, name the entity of the loop something else.", name.repr);
+                adv();
+                if (!adv() || current->type != token_type::BRACKET_CLOSED)
+                    COMP_ERROR(RS_SYNTAX_ERROR, "Expected ')'.");
+                if (!adv() || current->type != token_type::CBRACKET_OPEN)
+                    COMP_ERROR(RS_SYNTAX_ERROR, "Expected loop body.");
+                // the entity is @s in the body.
+                int depth = 0;
+                for (size_t k = _At; k < S; k++)
+                {
+                    token& t = tokens.at(k);
+                    token* after = k + 1 < S ? &tokens.at(k + 1) : nullptr;
+                    if (t.type == token_type::CBRACKET_OPEN)
+                        depth++;
+                    else if (t.type == token_type::CBRACKET_CLOSED && --depth == 0)
+                        break;
+                    else if (t.type == token_type::WORD && t.repr == name.repr
+                          && !(after && (after->type == token_type::BRACKET_OPEN || (after->type == token_type::SYMBOL && after->info == ':'))))
+                    {
+                        t.type = token_type::SELECTOR_LITERAL;
+                        t.info = RS_SELECTOR_KW_ID;
+                        t.repr = "s";
+                    }
+                }
+                program(rbc_command(rbc_instruction::FOR, rbc_constant(token_type::SELECTOR_LITERAL, selector->repr, &selector->trace)));
+
+                program.scopeStack.push(rbc_scope_type::LOOP);
+                program.currentScope++;
+                _loopDepth++;
+                break;
+            }
+            if (current->type == token_type::SYMBOL && current->info == ':')
+            {
+                if (exists)
+                    COMP_ERROR(RS_SYNTAX_ERROR, "Variable cannot be reinitialized with a different type.");
+                rs_type_info type = typeparse();
+                if (err->trace.ec)
+                    return program;
+                variable = std::make_shared<rs_variable>(name, program.currentScope + 1, !program.currentFunction);
+                variable->type_info = type;
+            }
+            else if (!exists)
+                COMP_ERROR(RS_SYNTAX_ERROR, "Unknown variable, give it a type to declare it.");
+
+            // for (k: string in map): the body runs for every key the map had when the loop started.
+            token* after = peek();
+            std::shared_ptr<rs_variable> map = nullptr;
+            if (current->type == token_type::KW_IN && after && after->type == token_type::WORD
+             && (map = program.getVariable(after->repr)) && map->type_info.isMap())
+            {
+                if (!variable->type_info.equals(RS_STRING_KW_ID))
+                    COMP_ERROR(RS_SYNTAX_ERROR, "Map loop variables must be of type string.");
+                adv();
+                if (!adv() || current->type != token_type::BRACKET_CLOSED)
+                    COMP_ERROR(RS_SYNTAX_ERROR, "Expected ')'.");
+                if (!adv() || current->type != token_type::CBRACKET_OPEN)
+                    COMP_ERROR(RS_SYNTAX_ERROR, "Expected loop body.");
+                if (!exists)
+                {
+                    program(rbc_commands::variables::create(variable, rbc_constant(token_type::STRING_LITERAL, "")));
+                    if (!program.currentFunction)
+                        program.globalVariables.push_back(variable);
+                    else
+                        program.currentFunction->localVariables.insert({variable->name, {variable, false}});
+                }
+                program(rbc_command(rbc_instruction::FOR, variable, map));
+
+                program.scopeStack.push(rbc_scope_type::LOOP);
+                program.currentScope++;
+                _loopDepth++;
+                break;
+            }
+            if (!variable->type_info.equals(RS_INT_KW_ID))
+                COMP_ERROR(RS_SYNTAX_ERROR, "Range loop variables must be of type int.");
+            if (current->type != token_type::KW_IN)
+                COMP_ERROR(RS_SYNTAX_ERROR, "Expected keyword 'in'.");
+
+            // bounds are int literals or int variables.
+            auto bound = [&]() -> std::shared_ptr<rbc_value>
+            {
+                if (!adv())
+                    COMP_ERROR_R(RS_EOF_ERROR, "Unexpected EOF.", nullptr);
+                if (current->type == token_type::INT_LITERAL)
+                    return std::make_shared<rbc_value>(rbc_constant(current->type, current->repr, &current->trace));
+                if (current->type == token_type::WORD)
+                {
+                    std::shared_ptr<rs_variable> var = program.getVariable(current->repr);
+                    if (!var)
+                        COMP_ERROR_R(RS_SYNTAX_ERROR, "Unknown variable.", nullptr);
+                    if (!var->type_info.equals(RS_INT_KW_ID))
+                        COMP_ERROR_R(RS_SYNTAX_ERROR, "Range bounds must be of type int.", nullptr);
+                    return std::make_shared<rbc_value>(var);
+                }
+                COMP_ERROR_R(RS_SYNTAX_ERROR, "Range bounds must be an int or a variable.", nullptr);
+            };
+            std::shared_ptr<rbc_value> from = bound();
+            if (!from)
+                return program;
+            if (!adv() || current->type != token_type::RANGE)
+                COMP_ERROR(RS_SYNTAX_ERROR, "Expected range ('..').");
+            std::shared_ptr<rbc_value> to = bound();
+            if (!to)
+                return program;
+            if (!adv() || current->type != token_type::BRACKET_CLOSED)
+                COMP_ERROR(RS_SYNTAX_ERROR, "Expected ')'.");
+            if (!adv() || current->type != token_type::CBRACKET_OPEN)
+                COMP_ERROR(RS_SYNTAX_ERROR, "Expected loop body.");
+
+            if (exists)
+                program(rbc_commands::variables::set(variable, *from));
+            else
+            {
+                program(rbc_commands::variables::create(variable, *from));
+                if (!program.currentFunction)
+                    program.globalVariables.push_back(variable);
+                else
+                    program.currentFunction->localVariables.insert({variable->name, {variable, false}});
+            }
+            program(rbc_command(rbc_instruction::FOR, variable, *from, *to));
+
+            program.scopeStack.push(rbc_scope_type::LOOP);
+            program.currentScope++;
+            _loopDepth++;
+            break;
+        }
+        case token_type::KW_BREAK:
+        case token_type::KW_CONTINUE:
+        {
+            const bool isBreak = current->type == token_type::KW_BREAK;
+            if (_loopDepth == 0)
+                COMP_ERROR(RS_SYNTAX_ERROR, "'{}' can only be used inside a loop.", current->repr);
+            if (!adv() || current->type != token_type::LINE_END)
+                COMP_ERROR(RS_SYNTAX_ERROR, "Missing semicolon.");
+            program(rbc_command(isBreak ? rbc_instruction::BREAK : rbc_instruction::CONTINUE));
+            break;
+        }
+        case token_type::KW_YIELD:
+        {
+            if (!program.currentFunction)
+                COMP_ERROR(RS_SYNTAX_ERROR, "Yield can only be used inside an async function.");
+            auto& decorators = program.currentFunction->decorators;
+            if (std::find(decorators.begin(), decorators.end(), rbc_function_decorator::ASYNC) == decorators.end())
+                COMP_ERROR(RS_SYNTAX_ERROR, "Yield can only be used inside an async function, mark it with 'async'.");
+            // the function is split at yields, so they can't be inside a branch or a loop.
+            if (program.scopeStack.empty() || program.scopeStack.top() != rbc_scope_type::FUNCTION)
+                COMP_ERROR(RS_UNSUPPORTED_OPERATION_ERROR, "Yield can only be used at the top level of a function body.");
+
+            std::string ticks = "1";
+            if (!adv())
+                COMP_ERROR(RS_EOF_ERROR, "Missing semicolon.");
+            if (current->type == token_type::INT_LITERAL)
+            {
+                ticks = current->repr;
+                if (std::stoi(ticks) < 1)
+                    COMP_ERROR(RS_SYNTAX_ERROR, "Yield must wait at least one tick.");
+                if (!adv())
+                    COMP_ERROR(RS_EOF_ERROR, "Missing semicolon.");
+            }
+            if (current->type != token_type::LINE_END)
+                COMP_ERROR(RS_SYNTAX_ERROR, "Missing semicolon.");
+            program(rbc_command(rbc_instruction::YIELD, rbc_constant(token_type::INT_LITERAL, ticks)));
+            break;
+        }
         case token_type::KW_ELSE:
         {
             if (program.lastScope != rbc_scope_type::IF && program.lastScope != rbc_scope_type::ELIF)
@@ -1403,14 +2066,18 @@ rbc_program torbc(token_list& tokens, std::string fName, std::string& content, r
     return program;
 }
 void preprocess(token_list& tokens, std::string fName, std::string& content, rs_error* err,
-                std::shared_ptr<std::vector<std::filesystem::path>> visited)
+                std::shared_ptr<std::vector<std::filesystem::path>> visited, lex_cache* cache)
 {
     long long       _At = 0;
-    const long long S   = tokens.size();
+    // grows with every file included.
+    long long       S   = tokens.size();
     std::filesystem::path rootPath = std::filesystem::absolute(fName);
 
     if(!visited)
         visited = std::make_shared<std::vector<std::filesystem::path>>();
+    // token traces index into visited, the entry file is 0.
+    if(visited->empty())
+        visited->push_back(rootPath);
 
     do
     {
@@ -1429,7 +2096,18 @@ void preprocess(token_list& tokens, std::string fName, std::string& content, rs_
                 if (visited && std::find(visited->begin(), visited->end(), filePath) != visited->end())
                     COMP_ERROR_R(RS_ALREADY_INCLUDED_ERROR, "This file has already been included.",);
                 visited->push_back(filePath);
-                std::string fileContent = readFile(filePath);
+
+                std::shared_ptr<const lex_cache::entry> cached;
+                auto load = [&]() -> std::string
+                {
+                    if (!cache)
+                        return readFile(filePath);
+                    cached = cache->get(filePath, err);
+                    return cached ? cached->content : std::string();
+                };
+                std::string fileContent = load();
+                if (err->trace.ec)
+                    return;
 
                 if (fileContent.empty())
                 {
@@ -1437,8 +2115,11 @@ void preprocess(token_list& tokens, std::string fName, std::string& content, rs_
                     {
                         std::filesystem::path libPath = std::filesystem::absolute(RS_CONFIG.get<std::string>("lib"));
                         filePath = libPath / file;
+                        visited->push_back(filePath);
 
-                        fileContent = readFile(filePath);
+                        fileContent = load();
+                        if (err->trace.ec)
+                            return;
 
                         if (fileContent.empty())
                             COMP_ERROR_R(RS_SYNTAX_ERROR, "Could not find import '{}'.", , path.repr);
@@ -1452,12 +2133,17 @@ void preprocess(token_list& tokens, std::string fName, std::string& content, rs_
                 if (_At + 1 >= S || tokens.at(++_At).type != token_type::LINE_END)
                     COMP_ERROR_R(RS_SYNTAX_ERROR, "Missing semicolon.",);
                 std::string filePathStr = filePath.string();
-                token_list fileTokens = tlex(filePathStr, fileContent, err);
+                token_list fileTokens = cached ? cached->tokens : tlex(filePathStr, fileContent, err);
 
-                preprocess(fileTokens, filePathStr, fileContent, err, visited);
+                preprocess(fileTokens, filePathStr, fileContent, err, visited, cache);
 
                 if(err->trace.ec)
                     return;
+                // tokens of files it uses were tagged by the nested preprocess.
+                const uint32_t fileIndex = std::find(visited->begin(), visited->end(), filePath) - visited->begin();
+                for(token& fileToken : fileTokens)
+                    if(fileToken.trace.file == 0)
+                        fileToken.trace.file = fileIndex;
                 const size_t offset = fileContent.length() + 1; // + 1 for \n
                 // const auto   lines  = std::count(fileContent.begin(), fileContent.end(), '\n');
                 for(size_t i = 0; i < tokens.size(); i++)
@@ -1471,6 +2157,7 @@ void preprocess(token_list& tokens, std::string fName, std::string& content, rs_
 
                 content = fileContent + '\n' + content;
                 _At += fileTokens.size();
+                S = tokens.size();
 
                 break;
             }
@@ -1487,41 +2174,911 @@ mc_program tomc(rbc_program& program, const std::string& moduleName, std::string
     mc_program mcprogram;
     conversion::CommandFactory factory(mcprogram, program);
     
-    auto parseFunction = [&](std::vector<rbc_command>& instructions) -> mccmdlist
+    // a lowered chain leaves its function through return run, older packs keep the guarded commands.
+    const bool returnRun = RS_CONFIG.getOr<int>("versionid", 0) >= MC_RETURN_RUN_PACK_FORMAT;
+    const bool lowerBranches = RS_CONFIG.getOr<int>("lower_branches", 1) && returnRun;
+    // with a profile, branches and loops are laid out for how often they ran. compiling is the source
+    // name of the function being compiled, which the profile is keyed by.
+    const pgo::profile* profile = rs_context::current().profile.get();
+    std::string compiling = RS_GLOBAL_SOURCE_NAME;
+    auto heatOf = [&](const rbc_command& instruction)
+    { return profile ? profile->of(compiling, instruction.origin.line) : pgo::heat::UNKNOWN; };
+
+    std::function<mccmdlist(std::vector<rbc_command>&)> parseFunction;
+    // arguments pushed for the next inbuilt call. inbuilts are expanded at compile time, so their arguments are
+    // never stored, while the instructions computing them still run.
+    std::vector<rbc_value> inbuiltArguments;
+
+    // emits the commands computing the condition of an IF, NIF or ELIF instruction with
+    // non constant operands, returning the comparison register holding the result.
+    auto condition = [&](rbc_command& instruction) -> std::shared_ptr<comparison_register>
     {
-        for(size_t i = 0; i < instructions.size(); i++)
-        {
-            auto& instruction = instructions.at(i);
-            const size_t size = instruction.parameters.size();
+        const size_t size = instruction.parameters.size();
+        RS_ASSERT_SIZE(size > 0);
+        const bool invertFlag = instruction.type == rbc_instruction::NIF || instruction.type == rbc_instruction::NELIF;
 
-            switch(instruction.type)
+        if (size == 1)
+        {
+            // bool convertable if statement
+            rbc_value& param = *instruction.parameters.at(0);
+            switch(param.index())
             {
-                case rbc_instruction::CREATE:
+                case 1:
                 {
-                    RS_ASSERT_SIZE(size > 0);
-                    rs_variable& var = *std::get<sharedt<rs_variable>>(*instruction.parameters.at(0));
-                    if (instruction.parameters.size() == 1)
-                        factory.createVariable(var);
+                    rbc_register& reg = *std::get<1>(param);
+                    std::shared_ptr<comparison_register> outReg = nullptr;
+                    if (reg.operable)
+                    {
+                        // makes reg if needed
+                        outReg = factory.compareNull(true, MC_OPERABLE_REG(INS_L(STR(reg.id))), !invertFlag);
+                    }
                     else
                     {
-                        rbc_value& val = *instruction.parameters.at(1);
-                        factory.createVariable(var, val);
+                        outReg = factory.compareNull(false, MC_NOPERABLE_REG(reg.id), !invertFlag);
+                        // see if contents is also not 0
                     }
-                    // RS_ASSERT_SUCCESS;
+                    return outReg;
+                }
+                case 2:
+                {
+                    rs_variable& var = *std::get<2>(param);
+                    std::shared_ptr<comparison_register> outReg = factory.compareNull(false, MC_VARIABLE_VALUE(var.comp_info.varIndex), !invertFlag);
+                
+                    return outReg;
+                }
+                default:
+                    ERROR("Cannot compare rbc_value of unimplemented typeid to null. If you see this error, flag an issue.");
+            }
+            return nullptr;
+        }
+
+        RS_ASSERT_SIZE(size == 3);
+        rbc_value& lhs = *instruction.parameters.at(0);
+        rbc_constant& op = std::get<0>(*instruction.parameters.at(1));
+        bool eq = op.val == "==";
+        if (invertFlag) eq = !eq;
+
+        rbc_value& rhs = *instruction.parameters.at(2);
+
+        // commutative check, as no values are modified
+        std::shared_ptr<comparison_register> usedRegister = nullptr;
+        if (lhs.index() == rhs.index())
+        {
+            switch(lhs.index())
+            {
+                case 0:
+                {
+                    // two constants.
+                    WARN("Comparing two constants is not good practice.");
                     break;
                 }
-                case rbc_instruction::SAVE:
+                case 1:
                 {
-                    RS_ASSERT_SIZE(size == 2);
-                    rbc_value& reg = *instruction.parameters.at(0);
-                    switch(reg.index())
+                    // two registers
+                    rbc_register& reg  = *std::get<1>(lhs);
+                    rbc_register& reg2 = *std::get<1>(rhs);
+
+                    if ((reg.operable && !reg2.operable) || (!reg.operable && reg2.operable))
                     {
-                        // register
-                        case 1:
-                        {
-                            rbc_register& regist = *std::get<sharedt<rbc_register>>(reg);
-                            regist.vacant = false;
-                            factory.setRegisterValue(regist,
+                        // store result in storage and compare
+                        rbc_register& operable =  reg2.operable ? reg2 : reg;
+                        rbc_register& noperable = reg2.operable ? reg  : reg2; 
+                        factory.add( factory.getRegisterValue(noperable).storeResult(PADR(scoreboard) MC_TEMP_SCOREBOARD_STORAGE) );
+
+                        usedRegister = factory.compare("score", MC_OPERABLE_REG(INS_L(STR(operable.id))), eq, MC_TEMP_SCOREBOARD_STORAGE);
+                    }
+                    // both are either operable or not operable
+                    else if (reg.operable)
+                        usedRegister = factory.compare("score", MC_OPERABLE_REG(INS_L(STR(reg.id))), eq, MC_OPERABLE_REG(INS_L(STR(reg2.id))));
+                    else // TODO fix NOPERABLE_REG_GET: not raw, has extra commands at start
+                        usedRegister = factory.compare("data", MC_NOPERABLE_REG_GET(reg.id), eq, MC_NOPERABLE_REG_GET(reg2.id));
+                    break;
+                }
+                case 2:
+                {
+                    rs_variable& var  = *std::get<2>(lhs);
+                    rs_variable& var2 = *std::get<2>(rhs);
+
+                    usedRegister = factory.compare("data", RS_PROGRAM_STORAGE SEP MC_VARIABLE_VALUE(var.comp_info.varIndex), eq,
+                                            RS_PROGRAM_STORAGE SEP MC_VARIABLE_VALUE(var2.comp_info.varIndex));
+
+                    break;
+                }
+                default:
+                    WARN("Unimplemented comparison.");
+            }
+        }
+        else
+        {
+            {
+            result_pair<sharedt<rbc_register>, rbc_constant> res = 
+                commutativeVariantEquals<sharedt<rbc_register>, rbc_constant, rbc_value>(1, lhs, 0, rhs);
+            if (res)
+            {
+                rbc_register& reg =   *res.i1;
+                rbc_constant& con =   *res.i2;
+
+                if (reg.operable)
+                {
+                    usedRegister = factory.compare("score", MC_OPERABLE_REG(INS_L(STR(reg.id))), eq, con.val, true);
+                }
+                else
+                {
+                    factory.create_and_push(MC_DATA_CMD_ID, MC_TEMP_STORAGE_SET_CONST(con.val));
+                    // TODO: fix to not have leading keywords!
+                    usedRegister = factory.compare("data", MC_NOPERABLE_REG_GET(reg.id), eq, MC_TEMP_STORAGE);
+                }
+                return usedRegister;
+            }
+            }
+            {
+            result_pair<sharedt<rbc_register>, sharedt<rs_variable>> res = 
+                commutativeVariantEquals<sharedt<rbc_register>, sharedt<rs_variable>, rbc_value>(1, lhs, 2, rhs);
+
+            if (res)
+            {
+                rbc_register& reg = *res.i1;
+                rs_variable&  var = *res.i2;
+
+                if (reg.operable)
+                    factory.getRegisterValue(reg).storeResult(PADR(storage) MC_TEMP_STORAGE, "int", 1);
+                else
+                    factory.copyStorage(MC_TEMP_STORAGE, MC_NOPERABLE_REG_GET(reg.id));
+                usedRegister = factory.compare("data", MC_VARIABLE_VALUE(var.comp_info.varIndex), eq, MC_TEMP_STORAGE);
+                return usedRegister;
+            }
+            }
+            {
+            result_pair<sharedt<rs_variable>, rbc_constant> res = 
+                commutativeVariantEquals<sharedt<rs_variable>, rbc_constant, rbc_value>(2, lhs, 0, rhs);
+
+            if (res)
+            {
+                rs_variable&  var = *res.i1;
+                rbc_constant& con = *res.i2;
+                
+                usedRegister = factory.compare("data", MC_VARIABLE_VALUE(var.comp_info.varIndex), eq, con.val, true);
+                return usedRegister;
+            }
+            }
+        }
+        return usedRegister;
+    };
+    // compiles instructions into their own command list, outside of the blocks of the function being built.
+    auto compileDetached = [&](std::vector<rbc_command> instructions) -> mccmdlist
+    {
+        mccmdlist outer = factory.detach();
+        auto blocks = mcprogram.blocks;
+        mcprogram.blocks = {};
+
+        mccmdlist commands = parseFunction(instructions);
+
+        mcprogram.blocks = blocks;
+        factory.attach(outer);
+        return commands;
+    };
+    // a rooted command running the commands, the command itself if there is only one
+    // and it can't return out of the function it is moved into.
+    auto runnable = [&](const mccmdlist& commands) -> std::string
+    {
+        if (commands.size() == 1 && !commands.front().macro)
+        {
+            const std::string& body = commands.front().body;
+            if (!body.starts_with("return") && body.find(" return ") == std::string::npos)
+                return body;
+        }
+        return "function " + mcprogram.addGeneratedFunction(commands, moduleName);
+    };
+    // the compound a helper taking a runtime index or key as its 'value' macro argument is run with.
+    auto indexArguments = [&](rbc_value& index) -> std::string
+    {
+        if (index.index() == 2)
+            return ARR_AT(RS_PROGRAM_VARIABLES, STR(std::get<2>(index)->comp_info.varIndex));
+        rbc_register& reg = *std::get<1>(index);
+        if (reg.operable)
+            factory.add(factory.getRegisterValue(reg).storeResult(PADR(storage) RS_PROGRAM_STORAGE SEP MC_LIST_INDEX, "int", 1));
+        else
+            factory.copyStorage(MC_LIST_INDEX, ARR_AT(RS_PROGRAM_REGISTERS, STR(reg.id)));
+        return MC_LIST_INDEX_ARGUMENTS;
+    };
+    // adds command, made for the path of the element of list at index. a constant index is written into the
+    // path. a runtime one is the macro argument of a helper holding the command, run with the compound that has
+    // the index as 'value'. without macros, the list is rotated until the element is first, and then on until it
+    // is back in order, which takes as many commands as the list is long.
+    auto listElement = [&](rs_variable& list, rbc_value& index, const std::function<mc_command(const std::string&)>& command)
+    {
+        auto raw = [](const std::string& body) { return mc_command{false, MC_RAW_CMD_ID, body}; };
+        const std::string path = MC_VARIABLE_VALUE(list.comp_info.varIndex);
+        if (index.index() == 0)
+        {
+            mc_command cmd = command(path + '[' + std::get<0>(index).val + ']');
+            factory.add(cmd);
+            return;
+        }
+        if (RS_CONFIG.getOr<int>("list_index_macros", 1) && RS_CONFIG.getOr<int>("versionid", 0) >= MC_MACRO_PACK_FORMAT)
+        {
+            mc_command line = command(path + "[$(value)]").addroot();
+            line.body  = '$' + line.body;
+            line.macro = true;
+            mc_command call = raw("function " + mcprogram.addGeneratedFunction({line}, moduleName) + " with storage " RS_PROGRAM_STORAGE SEP + indexArguments(index));
+            factory.add(call);
+            return;
+        }
+        mc_function rotate;
+        rotate.name = util::hashToHex(util::stableHash("rotate:" + path));
+        rotate.modulePath = {MC_GENERATED_FOLDER};
+        rotate.generated = true;
+        const std::string location = rotate.location(moduleName);
+        if (std::none_of(mcprogram.functions.begin(), mcprogram.functions.end(), [&](const mc_function& f) { return f.generated && f.name == rotate.name; }))
+        {
+            rotate.commands = {
+                raw("execute if score " MC_LIST_ROTATE_SCORE " matches ..0 run return 0"),
+                raw("data modify storage " RS_PROGRAM_STORAGE SEP + path + " append from storage " RS_PROGRAM_STORAGE SEP + path + "[0]"),
+                raw("data remove storage " RS_PROGRAM_STORAGE SEP + path + "[0]"),
+                raw("scoreboard players remove " MC_LIST_ROTATE_SCORE " 1"),
+                raw("function " + location)
+            };
+            mcprogram.functions.push_back(std::move(rotate));
+        }
+        std::string read;
+        if (index.index() == 2)
+            read = "data " MC_GET_VARIABLE_VALUE(std::get<2>(index)->comp_info.varIndex);
+        else if (std::get<1>(index)->operable)
+            read = "scoreboard " MC_OPERABLE_REG_GET(std::get<1>(index)->id);
+        else
+            read = "data " MC_NOPERABLE_REG_GET(std::get<1>(index)->id);
+        mccmdlist commands = {
+            raw("execute store result score " MC_LIST_ROTATE_SCORE " run " + read),
+            raw("execute store result score " MC_LIST_LENGTH_SCORE " run data get storage " RS_PROGRAM_STORAGE SEP + path),
+            raw("scoreboard players operation " MC_LIST_ROTATE_SCORE " %= " MC_LIST_LENGTH_SCORE),
+            raw("scoreboard players operation " MC_LIST_LENGTH_SCORE " -= " MC_LIST_ROTATE_SCORE),
+            raw("function " + location),
+            command(path + "[0]"),
+            raw("scoreboard players operation " MC_LIST_ROTATE_SCORE " = " MC_LIST_LENGTH_SCORE),
+            raw("function " + location)
+        };
+        for (mc_command& cmd : commands)
+            factory.add(cmd);
+    };
+    // adds the commands made for the entry of map under key, given the path of its value and the key. a constant
+    // key is written into the paths, a runtime one is the macro argument of a helper holding the commands, so an
+    // entry is one path access however big the map is. without macros, only constant keys can be compiled.
+    auto mapEntry = [&](rs_variable& map, rbc_value& key, const std::function<mccmdlist(const std::string&, const std::string&)>& commands)
+    {
+        const std::string path = MC_VARIABLE_VALUE(map.comp_info.varIndex);
+        if (key.index() == 0)
+        {
+            const std::string& k = std::get<0>(key).val;
+            for (mc_command& cmd : commands(MC_MAP_VALUE(path, k), k))
+                factory.add(cmd);
+            return;
+        }
+        if (RS_CONFIG.getOr<int>("versionid", 0) < MC_MACRO_PACK_FORMAT)
+        {
+            err = std::format("Map keys other than string literals need macros, set versionid to {} or above.", MC_MACRO_PACK_FORMAT);
+            return;
+        }
+        mccmdlist lines = commands(MC_MAP_VALUE(path, "$(value)"), "$(value)");
+        for (mc_command& line : lines)
+        {
+            line.addroot();
+            line.body  = '$' + line.body;
+            line.macro = true;
+        }
+        mc_command call{false, MC_RAW_CMD_ID, "function " + mcprogram.addGeneratedFunction(lines, moduleName) + " with storage " RS_PROGRAM_STORAGE SEP + indexArguments(key)};
+        factory.add(call);
+    };
+    // lowers a chain comparing one int variable against constants to a dispatch on its value. where macros
+    // are available and the values are dense, the value names the function of its case, so dispatching is
+    // one call. otherwise the cases are split in a binary search over the value, taking log2(n) checks.
+    auto jumpTable = [&](rs_variable& subject, std::vector<std::pair<int, std::vector<rbc_command>>>& cases,
+                         std::vector<rbc_command>* otherwise)
+    {
+        std::stable_sort(cases.begin(), cases.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        std::vector<mccmdlist> bodies;
+        uint64_t hash = util::stableHash("jumptable");
+        for (auto& _case : cases)
+        {
+            bodies.push_back(compileDetached(_case.second));
+            if (!err.empty())
+                return;
+            hash = util::stableHash(std::to_string(_case.first) + '\n', hash);
+            for (const mc_command& cmd : bodies.back())
+                hash = util::stableHash(cmd.body + '\n', hash);
+        }
+        std::string fallback;
+        if (otherwise)
+        {
+            mccmdlist body = compileDetached(*otherwise);
+            if (!err.empty())
+                return;
+            if (!body.empty())
+                fallback = runnable(body);
+        }
+
+        auto raw = [](const std::string& body) { return mc_command{false, MC_RAW_CMD_ID, body}; };
+        const std::string value = MC_TEMP_SCOREBOARD_STORAGE;
+        const std::string matches = "execute if score " + value + " matches ";
+
+        mccmdlist root{raw("execute store result score " + value + " run data " MC_GET_VARIABLE_VALUE(subject.comp_info.varIndex))};
+
+        const int low  = cases.front().first, high = cases.back().first;
+        const long long span = static_cast<long long>(high) - low + 1;
+        const bool macros = RS_CONFIG.getOr<int>("jumptable_macros", 1) && RS_CONFIG.getOr<int>("versionid", 0) >= MC_MACRO_PACK_FORMAT;
+
+        if (macros && span <= static_cast<long long>(cases.size()) * 2 && span <= RS_CONFIG.getOr<int>("jumptable_max_span", 256))
+        {
+            // one function per value in the range, named after the value. gaps run the else branch.
+            const std::string table = "jt_" + util::hashToHex(hash);
+            const bool exists = std::any_of(mcprogram.functions.begin(), mcprogram.functions.end(), [&](const mc_function& f)
+                                            { return f.pinned && f.modulePath.size() == 2 && f.modulePath.back() == table; });
+            size_t next = 0;
+            for (int v = low; v <= high && !exists; v++)
+            {
+                mc_function _case;
+                _case.name = std::to_string(v);
+                _case.modulePath = {MC_GENERATED_FOLDER, table};
+                _case.generated = true;
+                _case.pinned = true;
+                if (next < cases.size() && cases.at(next).first == v)
+                    _case.commands = bodies.at(next++);
+                else if (!fallback.empty())
+                    _case.commands = {raw(fallback)};
+                // a value can only appear once, later duplicates are never reached.
+                while (next < cases.size() && cases.at(next).first == v)
+                    next++;
+                mcprogram.functions.push_back(std::move(_case));
+            }
+            mc_command dispatch{true, MC_RAW_CMD_ID, "$function " + moduleName + ':' + MC_GENERATED_FOLDER + '/' + table + "/$(value)"};
+            const std::string dispatcher = mcprogram.addGeneratedFunction({dispatch}, moduleName);
+
+            root.push_back(raw(matches + std::to_string(low) + ".." + std::to_string(high) + " run return run function " + dispatcher +
+                               " with storage " RS_PROGRAM_STORAGE SEP ARR_AT(RS_PROGRAM_VARIABLES, STR(subject.comp_info.varIndex))));
+            if (!fallback.empty())
+                root.push_back(raw(fallback));
+        }
+        else
+        {
+            const int leafSize = std::max(1, RS_CONFIG.getOr<int>("jumptable_leaf_size", 2));
+            std::function<mccmdlist(size_t, size_t)> node = [&](size_t from, size_t to) -> mccmdlist
+            {
+                mccmdlist commands;
+                if (to - from <= static_cast<size_t>(leafSize))
+                {
+                    for (size_t k = from; k < to; k++)
+                    {
+                        const std::string _case = matches + std::to_string(cases.at(k).first) + " run return ";
+                        commands.push_back(raw(bodies.at(k).empty() ? _case + '0' : _case + "run " + runnable(bodies.at(k))));
+                    }
+                    if (!fallback.empty())
+                        commands.push_back(raw(fallback));
+                    return commands;
+                }
+                const size_t mid = from + (to - from) / 2;
+                commands.push_back(raw(matches + ".." + std::to_string(cases.at(mid - 1).first) +
+                                       " run return run function " + mcprogram.addGeneratedFunction(node(from, mid), moduleName)));
+                commands.push_back(raw(runnable(node(mid, to))));
+                return commands;
+            };
+            mccmdlist tree = node(0, cases.size());
+            root.insert(root.end(), tree.begin(), tree.end());
+        }
+        mc_command call = raw("function " + mcprogram.addGeneratedFunction(root, moduleName));
+        factory.add(call);
+    };
+    // lowers the if/elif/else chain starting at instructions[i] to guarded calls, rather than guarding
+    // every command of every branch with its comparison register. each branch is only entered once,
+    // and a chain stops checking conditions at the first branch taken (return run function).
+    // on success i is left on the ENDIF of the chain. returns false if the chain has to be compiled
+    // the old way: constant conditions are folded there, and returns would only leave the branch.
+    auto lowerConditional = [&](std::vector<rbc_command>& instructions, size_t& i) -> bool
+    {
+        struct branch
+        {
+            rbc_command* condition; // nullptr for else
+            size_t start, end;
+        };
+        std::vector<branch> branches{{&instructions.at(i), i + 1, 0}};
+
+        size_t depth = 0, loopDepth = 0, j = i;
+        while (++j < instructions.size())
+        {
+            rbc_command& inst = instructions.at(j);
+            switch(inst.type)
+            {
+                case rbc_instruction::IF:
+                case rbc_instruction::NIF:
+                    depth++;
+                    break;
+                case rbc_instruction::LOOP:
+                case rbc_instruction::FOR:
+                    loopDepth++;
+                    break;
+                case rbc_instruction::ENDLOOP:
+                    loopDepth--;
+                    break;
+                case rbc_instruction::BREAK:
+                case rbc_instruction::CONTINUE:
+                    // these leave the loop body function, which a branch function would be in the way of.
+                    if (loopDepth == 0)
+                        return false;
+                    break;
+                case rbc_instruction::ELIF:
+                case rbc_instruction::NELIF:
+                case rbc_instruction::ELSE:
+                    if (depth > 0) break;
+                    branches.back().end = j;
+                    branches.push_back({inst.type == rbc_instruction::ELSE ? nullptr : &inst, j + 1, 0});
+                    break;
+                case rbc_instruction::ENDIF:
+                    if (depth == 0) goto _found;
+                    depth--;
+                    break;
+                case rbc_instruction::RET:
+                    return false;
+                default:
+                    break;
+            }
+        }
+        return false;
+    _found:
+        branches.back().end = j;
+        // compiling the branches moves the factory's origin, commands made here belong to the if.
+        const source_location head = instructions.at(i).origin;
+        for (branch& b : branches)
+        {
+            if (!b.condition) continue;
+            auto& params = b.condition->parameters;
+            if (params.empty() || (params.at(0)->index() == 0 && (params.size() == 1 || params.back()->index() == 0)))
+                return false;
+        }
+
+        auto slice = [&](const branch& b)
+        { return std::vector<rbc_command>(instructions.begin() + b.start, instructions.begin() + b.end); };
+
+        // computes the condition of the branch, its register is free again once the guard is made,
+        // as the branch only runs after the guard has been checked.
+        auto guard = [&](const branch& b, comparison_register& out) -> bool
+        {
+            std::shared_ptr<comparison_register> reg = condition(*b.condition);
+            if (!reg)
+            {
+                if (err.empty()) err = "Unsupported comparison in conditional.";
+                return false;
+            }
+            out = *reg;
+            reg->free();
+            return true;
+        };
+        i = j;
+
+        const int minCases = RS_CONFIG.getOr<int>("jumptable_min_cases", 4);
+        const bool tableSized = minCases > 0 && branches.size() >= static_cast<size_t>(minCases);
+        // every condition tests the same variable against a different constant, so at most one holds.
+        bool exclusive = false;
+        if (tableSized || (profile && branches.size() > 2))
+        {
+            rs_variable* subject = nullptr;
+            std::vector<std::pair<int, std::vector<rbc_command>>> cases;
+            std::vector<rbc_command> otherwise;
+            std::set<int> values;
+            bool table = true;
+            for (const branch& b : branches)
+            {
+                if (!b.condition)
+                {
+                    otherwise = slice(b);
+                    continue;
+                }
+                auto& params = b.condition->parameters;
+                if (b.condition->type == rbc_instruction::NIF || b.condition->type == rbc_instruction::NELIF ||
+                    params.size() != 3 || std::get<0>(*params.at(1)).val != "==")
+                {
+                    table = false;
+                    break;
+                }
+                result_pair<sharedt<rs_variable>, rbc_constant> res =
+                    commutativeVariantEquals<sharedt<rs_variable>, rbc_constant, rbc_value>(2, *params.at(0), 0, *params.at(2));
+                if (!res || res.i2->val_type != token_type::INT_LITERAL || (subject && subject != res.i1))
+                {
+                    table = false;
+                    break;
+                }
+                const rs_type_info& type = res.i1->type_info.type_id != -1 ? res.i1->type_info : res.i1->real_type_info;
+                if (type.type_id != RS_INT_KW_ID || type.array_count > 0)
+                {
+                    table = false;
+                    break;
+                }
+                subject = res.i1;
+                cases.push_back({std::stoi(res.i2->val), slice(b)});
+                values.insert(cases.back().first);
+            }
+            exclusive = table && values.size() == cases.size();
+            if (table && tableSized && cases.size() >= static_cast<size_t>(minCases))
+            {
+                factory.origin = head;
+                jumpTable(*subject, cases, branches.back().condition ? nullptr : &otherwise);
+                factory.origin = head;
+                return true;
+            }
+        }
+
+        if (branches.size() == 1)
+        {
+            comparison_register reg;
+            if (!guard(branches.front(), reg))
+                return true;
+
+            mccmdlist body = compileDetached(slice(branches.front()));
+            if (!err.empty() || body.empty())
+                return true;
+
+            const std::string run = runnable(body);
+            mc_command call = run.starts_with("execute ") ? mc_command{false, MC_EXEC_CMD_ID, run.substr(8)}
+                                                         : mc_command{false, MC_RAW_CMD_ID, run};
+            factory.origin = head;
+            factory.add(call.ifcmpreg(reg.operation, reg.id));
+            return true;
+        }
+
+        // only one branch of an exclusive chain can be taken, so it can test them in any order:
+        // most taken first. the else stays last.
+        if (exclusive && profile)
+        {
+            auto taken = [&](const branch& b)
+            { return b.start < b.end ? profile->count(compiling, instructions.at(b.start).origin.line) : 0; };
+            std::stable_sort(branches.begin(), branches.end() - (branches.back().condition ? 0 : 1),
+                             [&](const branch& a, const branch& b) { return taken(a) > taken(b); });
+        }
+
+        // build the chain in its own function, so a taken branch can return out of it.
+        mccmdlist outer = factory.detach();
+        auto blocks = mcprogram.blocks;
+        mcprogram.blocks = {};
+
+        for (size_t k = 0; k < branches.size(); k++)
+        {
+            const branch& b = branches.at(k);
+            const bool last = k == branches.size() - 1;
+            comparison_register reg;
+
+            factory.origin = b.condition ? b.condition->origin : head;
+            if (b.condition && !guard(b, reg))
+                break;
+
+            mccmdlist body = compileDetached(slice(b));
+            if (!err.empty())
+                break;
+            factory.origin = b.condition ? b.condition->origin : head;
+            if (body.empty())
+            {
+                // an empty branch still has to end the chain when taken.
+                if (!last && b.condition)
+                {
+                    mc_command stop{false, MC_RETURN_CMD_ID, "0"};
+                    factory.add(stop.ifcmpreg(reg.operation, reg.id));
+                }
+                continue;
+            }
+
+            const std::string run = runnable(body);
+            if (!b.condition)
+            {
+                mc_command call{false, MC_RAW_CMD_ID, run};
+                factory.add(call);
+                continue;
+            }
+            mc_command call{false, MC_RAW_CMD_ID, last ? run : "return run " + run};
+            factory.add(call.ifcmpreg(reg.operation, reg.id));
+        }
+
+        mccmdlist chain = factory.package();
+        factory.clear();
+        mcprogram.blocks = blocks;
+        factory.attach(outer);
+
+        if (!err.empty() || chain.empty())
+            return true;
+
+        mc_command call{false, MC_RAW_CMD_ID, runnable(chain)};
+        factory.origin = head;
+        factory.add(call);
+        return true;
+    };
+
+    struct loop_target
+    {
+        std::string next; // command running the next iteration, for continue.
+        std::string broken = ""; // run by break before returning, for loops a return alone doesn't stop.
+    };
+    std::vector<loop_target> loops;
+    size_t loopCount = 0;
+    // lowers the loop starting at instructions[i] (LOOP or FOR) to a self recursive function in _gen/.
+    // every call runs one iteration and calls itself as its last command, so break is a return and continue
+    // a return into the next iteration. range loops with constant bounds are unrolled when small enough.
+    // entity loops are one 'execute as <selector> at @s run function', the body runs once per entity.
+    // map loops take the next key from a copy of the map's keys each iteration.
+    // i is left on the ENDLOOP of the loop.
+    auto lowerLoop = [&](std::vector<rbc_command>& instructions, size_t& i)
+    {
+        const size_t head = i;
+        const bool range  = instructions.at(head).type == rbc_instruction::FOR && instructions.at(head).parameters.size() == 3;
+        const bool keyed  = instructions.at(head).type == rbc_instruction::FOR && instructions.at(head).parameters.size() == 2;
+        const bool entity = instructions.at(head).type == rbc_instruction::FOR && !range && !keyed;
+        // a for loop has no condition computed between its head and a WHILE.
+        const bool counted = range || keyed || entity;
+        size_t depth = 0, check = head, j = head;
+        bool jumps = false, breaks = false, continues = false;
+        while (++j < instructions.size())
+        {
+            rbc_command& inst = instructions.at(j);
+            if (inst.type == rbc_instruction::LOOP || inst.type == rbc_instruction::FOR)
+                depth++;
+            else if (inst.type == rbc_instruction::WHILE && depth == 0 && !counted && check == head)
+                check = j;
+            else if ((inst.type == rbc_instruction::BREAK || inst.type == rbc_instruction::CONTINUE) && depth == 0)
+            {
+                jumps = true;
+                breaks |= inst.type == rbc_instruction::BREAK;
+                continues |= inst.type == rbc_instruction::CONTINUE;
+            }
+            else if (inst.type == rbc_instruction::ENDLOOP)
+            {
+                if (depth == 0)
+                    break;
+                depth--;
+            }
+        }
+        if (j >= instructions.size() || (!counted && check == head))
+        {
+            err = "Unterminated loop. This error is a bug, flag it on github.";
+            return;
+        }
+        // continue runs the next iteration and leaves this one in a single command.
+        if (continues && !entity && !returnRun)
+        {
+            err = std::format("Continue needs return run, set versionid to {} or above.", MC_RETURN_RUN_PACK_FORMAT);
+            return;
+        }
+        i = j;
+
+        std::vector<rbc_command> prelude;
+        if (!counted)
+            prelude.assign(instructions.begin() + head + 1, instructions.begin() + check);
+        std::vector<rbc_command> body;
+        // variables declared in the body are created once, before the loop, and only set in it.
+        // creating them in the body would append a new variable every iteration.
+        for (size_t k = (counted ? head : check) + 1; k < j; k++)
+        {
+            rbc_command& inst = instructions.at(k);
+            if (inst.type != rbc_instruction::CREATE)
+            {
+                body.push_back(inst);
+                continue;
+            }
+            rs_variable& created = *std::get<2>(*inst.parameters.at(0));
+            factory.createVariable(created);
+            if (inst.parameters.size() > 1)
+            {
+                rbc_command set(rbc_instruction::SAVE);
+                set.parameters = inst.parameters;
+                body.push_back(set);
+            }
+            else if (created.type_info.isMap())
+            {
+                // a map declared in the body starts every iteration empty.
+                rbc_command clear(rbc_instruction::DELKEY);
+                clear.parameters = inst.parameters;
+                body.push_back(clear);
+            }
+        }
+
+        rbc_command& loop = instructions.at(counted ? head : check);
+        std::shared_ptr<rs_variable> counter = nullptr;
+        if (range)
+        {
+            counter = std::get<2>(*loop.parameters.at(0));
+            rbc_value& from = *loop.parameters.at(1);
+            rbc_value& to   = *loop.parameters.at(2);
+            if (from.index() == 0 && to.index() == 0)
+            {
+                const int low = std::stoi(std::get<0>(from).val), high = std::stoi(std::get<0>(to).val);
+                if (high <= low)
+                    return;
+                const long long iterations = static_cast<long long>(high) - low;
+                // hot loops get a bigger budget, cold ones stay a loop.
+                const pgo::heat heat = heatOf(instructions.at(head));
+                const int factor = heat == pgo::heat::HOT ? std::max(1, RS_CONFIG.getOr<int>("pgo_unroll_factor", 4)) : 1;
+                if (!jumps && heat != pgo::heat::COLD && iterations <= RS_CONFIG.getOr<int>("unroll_max_iterations", 16) * factor)
+                {
+                    mccmdlist unrolled = compileDetached(body);
+                    if (!err.empty())
+                        return;
+                    if (static_cast<long long>(unrolled.size()) * iterations <= RS_CONFIG.getOr<int>("unroll_budget", 64) * factor)
+                    {
+                        for (int v = low; v < high; v++)
+                        {
+                            if (v != low)
+                                factory.create_and_push(MC_DATA_CMD_ID, MC_VARIABLE_SET_CONST(counter->comp_info.varIndex, STR(v)));
+                            for (const mc_command& cmd : unrolled)
+                            {
+                                mc_command copy{cmd.macro, MC_RAW_CMD_ID, cmd.body};
+                                factory.add(copy);
+                            }
+                        }
+                        // leave the counter where the loop would have.
+                        factory.create_and_push(MC_DATA_CMD_ID, MC_VARIABLE_SET_CONST(counter->comp_info.varIndex, STR(high)));
+                        return;
+                    }
+                }
+            }
+        }
+        else if (!entity && loop.parameters.size() == 1 && loop.parameters.at(0)->index() == 0 && prelude.empty())
+        {
+            rbc_constant& _const = std::get<0>(*loop.parameters.at(0));
+            if (_const.val_type != token_type::INT_LITERAL)
+            {
+                err = std::format("Cannot convert typeid {} to boolean.", static_cast<int>(_const.val_type));
+                return;
+            }
+            if (std::stoi(_const.val) == 0)
+                return;
+        }
+
+        mc_function function;
+        function.name = util::hashToHex(util::stableHash(moduleName + ":loop" + std::to_string(loopCount++)));
+        function.modulePath = {MC_GENERATED_FOLDER};
+        function.generated = true;
+        const std::string location = function.location(moduleName);
+        // range loops step their counter before the next iteration, continue included.
+        const std::string next = range ? location + "_next" : location;
+        // execute as can't be stopped, so after a break the entities left skip the body.
+        const std::string broken = entity && breaks ? "_brk" + std::to_string(loopCount) + " " MC_TEMP_STORAGE_NAME : "";
+        // a map loop runs over a copy of the keys pushed for the call, so nested and recursive loops don't share it.
+        const std::string left = MC_MAP_KEYS_LEFT_TOP;
+
+        mccmdlist outer = factory.detach();
+        auto blocks = mcprogram.blocks;
+        mcprogram.blocks = {};
+
+        auto raw = [](const std::string& body) { return mc_command{false, MC_RAW_CMD_ID, body}; };
+        if (range)
+        {
+            const std::string value = MC_TEMP_SCOREBOARD_STORAGE;
+            rbc_value& to = *loop.parameters.at(2);
+            function.commands.push_back(raw("execute store result score " + value + " run data " MC_GET_VARIABLE_VALUE(counter->comp_info.varIndex)));
+            if (to.index() == 0)
+                function.commands.push_back(raw("execute if score " + value + " matches " + std::get<0>(to).val + ".. run return 0"));
+            else
+            {
+                function.commands.push_back(raw("execute store result score " MC_TEMP_SCOREBOARD_RHS " run data " MC_GET_VARIABLE_VALUE(std::get<2>(to)->comp_info.varIndex)));
+                function.commands.push_back(raw("execute if score " + value + " >= " MC_TEMP_SCOREBOARD_RHS " run return 0"));
+            }
+        }
+        else if (entity)
+        {
+            if (!broken.empty())
+                function.commands.push_back(raw("execute if score " + broken + " matches 1 run return 0"));
+        }
+        else if (keyed)
+        {
+            // every iteration takes the first key left, the map itself can change in the body.
+            function.commands.push_back(raw("execute unless data storage " RS_PROGRAM_STORAGE SEP + left + "[0] run return 0"));
+            function.commands.push_back(factory.makeCopyStorage(MC_VARIABLE_VALUE(std::get<2>(*loop.parameters.at(0))->comp_info.varIndex), left + "[0].k").addroot());
+            function.commands.push_back(raw("data remove storage " RS_PROGRAM_STORAGE SEP + left + "[0]"));
+        }
+        else
+        {
+            function.commands = parseFunction(prelude);
+            if (loop.parameters.size() > 1 || loop.parameters.at(0)->index() != 0)
+            {
+                std::shared_ptr<comparison_register> reg = condition(loop);
+                if (reg)
+                {
+                    mc_command stop{false, MC_RETURN_CMD_ID, "0"};
+                    stop.ifcmpreg(reg->operation == comparison_operation_type::EQ ? comparison_operation_type::NEQ
+                                                                                  : comparison_operation_type::EQ, reg->id);
+                    factory.add(stop);
+                    reg->free();
+                }
+                else if (err.empty())
+                    err = "Unsupported comparison in loop condition.";
+                mccmdlist guard = factory.package();
+                factory.clear();
+                function.commands.insert(function.commands.end(), guard.begin(), guard.end());
+            }
+        }
+
+        if (entity)
+            loops.push_back({"return 0", broken.empty() ? "" : "scoreboard players set " + broken + " 1"});
+        else
+            loops.push_back({"return run function " + next});
+        mccmdlist iteration = parseFunction(body);
+        loops.pop_back();
+
+        mcprogram.blocks = blocks;
+        factory.attach(outer);
+        if (!err.empty())
+            return;
+
+        function.commands.insert(function.commands.end(), iteration.begin(), iteration.end());
+        if (!entity)
+            function.commands.push_back(raw("function " + next));
+        if (range)
+        {
+            mc_function step;
+            step.name = function.name + "_next";
+            step.modulePath = function.modulePath;
+            step.generated = true;
+            step.commands = {
+                raw("execute store result score " MC_TEMP_SCOREBOARD_STORAGE " run data " MC_GET_VARIABLE_VALUE(counter->comp_info.varIndex)),
+                raw("execute store result storage " MC_VARIABLE_VALUE_FULL(counter->comp_info.varIndex) " int 1 run scoreboard players add " MC_TEMP_SCOREBOARD_STORAGE " 1"),
+                raw("function " + location)
+            };
+            mcprogram.functions.push_back(std::move(step));
+        }
+        mcprogram.functions.push_back(std::move(function));
+
+        factory.origin = instructions.at(head).origin;
+        if (!broken.empty())
+        {
+            mc_command reset = raw("scoreboard players set " + broken + " 0");
+            factory.add(reset);
+        }
+        if (keyed)
+        {
+            mc_command push = raw("data modify storage " RS_PROGRAM_STORAGE SEP MC_MAP_KEYS_LEFT " append from storage " RS_PROGRAM_STORAGE SEP
+                                  + MC_MAP_KEYS(MC_VARIABLE_VALUE(std::get<2>(*loop.parameters.at(1))->comp_info.varIndex)));
+            factory.add(push);
+        }
+        mc_command call = raw(entity ? "execute as @" + std::get<0>(*loop.parameters.at(0)).val + " at @s run function " + location
+                                     : "function " + location);
+        factory.add(call);
+        if (keyed)
+        {
+            mc_command pop = raw("data remove storage " RS_PROGRAM_STORAGE SEP + left);
+            factory.add(pop);
+        }
+    };
+
+    parseFunction = [&](std::vector<rbc_command>& instructions) -> mccmdlist
+    {
+        for(size_t i = 0; i < instructions.size(); i++)
+        {
+            auto& instruction = instructions.at(i);
+            const size_t size = instruction.parameters.size();
+            factory.origin = instruction.origin;
+
+            switch(instruction.type)
+            {
+                case rbc_instruction::CREATE:
+                {
+                    RS_ASSERT_SIZE(size > 0);
+                    rs_variable& var = *std::get<sharedt<rs_variable>>(*instruction.parameters.at(0));
+                    if (instruction.parameters.size() == 1)
+                        factory.createVariable(var);
+                    else
+                    {
+                        rbc_value& val = *instruction.parameters.at(1);
+                        factory.createVariable(var, val);
+                    }
+                    // RS_ASSERT_SUCCESS;
+                    break;
+                }
+                case rbc_instruction::SAVE:
+                {
+                    RS_ASSERT_SIZE(size == 2);
+                    rbc_value& reg = *instruction.parameters.at(0);
+                    switch(reg.index())
+                    {
+                        // register
+                        case 1:
+                        {
+                            rbc_register& regist = *std::get<sharedt<rbc_register>>(reg);
+                            regist.vacant = false;
+                            factory.setRegisterValue(regist,
                                                     *instruction.parameters.at(1));
                             break;
                         }
@@ -1602,24 +3159,8 @@ mc_program tomc(rbc_program& program, const std::string& moduleName, std::string
                     
                     if (std::find(func.decorators.begin(), func.decorators.end(), rbc_function_decorator::CPP) != func.decorators.end())
                     {
-                        long caret = i;
-                        std::vector<rbc_value> parameters;
-                        rbc_command* cmd;
-
-                        // we dont need the parameter instructions anymore.
-                        factory.clearBuffer();
-                        while(--caret >= 0 && (cmd = &instructions.at(caret))->type == rbc_instruction::PUSH)
-                        {
-                            parameters.push_back(*cmd->parameters.at(2));
-                            mcprogram.varStackCount--;
-                        }
-                        std::vector<rbc_value> reversed;
-                        reversed.reserve(parameters.size());
-
-                        for (auto it = parameters.rbegin(); it != parameters.rend(); ++it) {
-                            reversed.push_back(std::move(*it));
-                        }
-                        parameters = std::move(reversed);
+                        std::vector<rbc_value> parameters = std::move(inbuiltArguments);
+                        inbuiltArguments.clear();
                         auto decl = inb_impls::INB_IMPLS_MAP.find(name);
                         if (decl == inb_impls::INB_IMPLS_MAP.end())
                         {
@@ -1627,6 +3168,9 @@ mc_program tomc(rbc_program& program, const std::string& moduleName, std::string
                             return {};
                         }
                         decl->second(program, factory, parameters, err);
+                        for (rbc_value& parameter : parameters)
+                            if (parameter.index() == 1)
+                                std::get<1>(parameter)->free();
                         if (!err.empty())
                             return {}; // todo can printerr here!!!
                     }
@@ -1651,17 +3195,27 @@ mc_program tomc(rbc_program& program, const std::string& moduleName, std::string
                 {
                     RS_ASSERT_SIZE(size >= 2);
 
-                    // store PUSH generated commands into a buffer so that if an inbuilt function is called,
-                    // we can clear the buffer as the function is handled at compile time.
+                    rbc_constant funcName = std::get<0>(*instruction.parameters.at(0));
+                    rbc_constant paramName = std::get<0>(*instruction.parameters.at(1));
+                    if (size == 3)
+                    {
+                        auto inbuilt = program.functions.find(funcName.val);
+                        if (inbuilt != program.functions.end() && std::find(inbuilt->second->decorators.begin(), inbuilt->second->decorators.end(), rbc_function_decorator::CPP) != inbuilt->second->decorators.end())
+                        {
+                            // taken until the call reads it, temporaries made for later arguments can't reuse it.
+                            if (instruction.parameters.at(2)->index() == 1)
+                                std::get<1>(*instruction.parameters.at(2))->vacant = false;
+                            inbuiltArguments.push_back(*instruction.parameters.at(2));
+                            break;
+                        }
+                    }
+                    // store PUSH generated commands into a buffer until the function is called.
                     if (!factory.usingBuffer())
                     {
                         factory.createBuffer();
                         factory.enableBuffer();
                     }
 
-                    rbc_constant funcName = std::get<0>(*instruction.parameters.at(0));
-                    rbc_constant paramName = std::get<0>(*instruction.parameters.at(1));
-
                     std::unordered_map<std::string, std::shared_ptr<rbc_function>>::iterator func;
 
                     if (size == 4)
@@ -1671,219 +3225,79 @@ mc_program tomc(rbc_program& program, const std::string& moduleName, std::string
                         if(!fromModule)
                         {
                             err = "Function defined in module has caused seg fault. Flag this error on the github, it should not occur.";
-                            break;
-                        }
-                        else
-                            func = fromModule->functions.find(funcName.val);
-                    }
-                    else
-                        func = program.functions.find(funcName.val);
-                    // TODO: change to param index?
-                    rs_variable* param = func->second->getParameterByName(paramName.val);
-                    // TODO: add null checks here
-
-                    factory.createVariable(*param, *instruction.parameters.at(2));
-                    mcprogram.stack.push_back(param);
-
-                    break;
-                }
-                case rbc_instruction::IF:
-                case rbc_instruction::NIF:
-                {
-                _parseif:
-                    RS_ASSERT_SIZE(size > 0);
-                    const bool invertFlag = instruction.type == rbc_instruction::NIF;
-
-                    if (size == 1)
-                    {
-                        // bool convertable if statement
-                        rbc_value& param = *instruction.parameters.at(0);
-                        switch(param.index())
-                        {
-                            case 0:
-                            {
-                                rbc_constant& _const = std::get<0>(param);
-                                if (_const.val_type != token_type::INT_LITERAL)
-                                {
-                                    // todo move error to torbc
-                                    err = std::format("Cannot convert typeid {} to boolean.", static_cast<int>(_const.val_type));
-                                    return {};
-                                }
-                                const int value = std::stoi(_const.val);
-
-                                if (value == 0)
-                                {
-                                    // skip instructions contained
-                                    while(++i < instructions.size())
-                                    {
-                                        auto& inst = instructions.at(i);
-                                        if (inst.type == rbc_instruction::ELSE)
-                                            goto skip;
-                                        if (inst.type == rbc_instruction::ENDIF)
-                                            break;
-                                    }
-
-                                    i++; // skip ENDIF
-                                }
-                                else
-                                {
-                                skip:
-                                    // remove next end if and parse as normal
-                                    size_t c = i;
-                                    while(++c < instructions.size())
-                                    {
-                                        auto& inst = instructions.at(c);
-                                        if(inst.type == rbc_instruction::ENDIF)
-                                        {
-                                            instructions.erase(instructions.begin() + c);
-                                            break;
-                                        }
-                                    }
-                                }
-                                break;
-                            }
-                            case 1:
-                            {
-                                rbc_register& reg = *std::get<1>(param);
-                                std::shared_ptr<comparison_register> outReg = nullptr;
-                                if (reg.operable)
-                                {
-                                    // makes reg if needed
-                                    outReg = factory.compareNull(true, MC_OPERABLE_REG(INS_L(STR(reg.id))), !invertFlag);
-                                }
-                                else
-                                {
-                                    outReg = factory.compareNull(false, MC_NOPERABLE_REG(reg.id), !invertFlag);
-                                    // see if contents is also not 0
-                                }
-                                mcprogram.blocks.push({0, outReg});
-                                break;
-                            }
-                            case 2:
-                            {
-                                rs_variable& var = *std::get<2>(param);
-                                std::shared_ptr<comparison_register> outReg = factory.compareNull(false, MC_VARIABLE_VALUE(var.comp_info.varIndex), !invertFlag);
-                                
-                                mcprogram.blocks.push({0, outReg});
-                                break;
-                            }
-                            default:
-                                ERROR("Cannot compare rbc_value of unimplemented typeid to null. If you see this error, flag an issue.");
+                            break;
                         }
-                        break;
+                        else
+                            func = fromModule->functions.find(funcName.val);
                     }
-                    
-                    RS_ASSERT_SIZE(size == 3);
-                    rbc_value& lhs = *instruction.parameters.at(0);
-                    rbc_constant& op = std::get<0>(*instruction.parameters.at(1));
-                    bool eq = op.val == "==";
-                    if (invertFlag) eq = !eq;
+                    else
+                        func = program.functions.find(funcName.val);
+                    // TODO: change to param index?
+                    rs_variable* param = func->second->getParameterByName(paramName.val);
+                    // TODO: add null checks here
 
-                    rbc_value& rhs = *instruction.parameters.at(2);
+                    factory.createVariable(*param, *instruction.parameters.at(2));
+                    mcprogram.stack.push_back(param);
 
-                    // commutative check, as no values are modified
-                    std::shared_ptr<comparison_register> usedRegister = nullptr;
-                    if (lhs.index() == rhs.index())
+                    break;
+                }
+                case rbc_instruction::IF:
+                case rbc_instruction::NIF:
+                {
+                    if (lowerBranches && lowerConditional(instructions, i))
                     {
-                        switch(lhs.index())
-                        {
-                            case 0:
-                            {
-                                // two constants.
-                                WARN("Comparing two constants is not good practice.");
-                                break;
-                            }
-                            case 1:
-                            {
-                                // two registers
-                                rbc_register& reg  = *std::get<1>(lhs);
-                                rbc_register& reg2 = *std::get<1>(rhs);
-
-                                if ((reg.operable && !reg2.operable) || (!reg.operable && reg2.operable))
-                                {
-                                    // store result in storage and compare
-                                    rbc_register& operable =  reg2.operable ? reg2 : reg;
-                                    rbc_register& noperable = reg2.operable ? reg  : reg2; 
-                                    factory.add( factory.getRegisterValue(noperable).storeResult(PADR(scoreboard) MC_TEMP_SCOREBOARD_STORAGE) );
-
-                                    usedRegister = factory.compare("score", MC_OPERABLE_REG(INS_L(STR(operable.id))), eq, MC_TEMP_SCOREBOARD_STORAGE);
-                                }
-                                // both are either operable or not operable
-                                else if (reg.operable)
-                                    usedRegister = factory.compare("score", MC_OPERABLE_REG(INS_L(STR(reg.id))), eq, MC_OPERABLE_REG(INS_L(STR(reg2.id))));
-                                else // TODO fix NOPERABLE_REG_GET: not raw, has extra commands at start
-                                    usedRegister = factory.compare("data", MC_NOPERABLE_REG_GET(reg.id), eq, MC_NOPERABLE_REG_GET(reg2.id));
-                                break;
-                            }
-                            case 2:
-                            {
-                                rs_variable& var  = *std::get<2>(lhs);
-                                rs_variable& var2 = *std::get<2>(rhs);
-
-                                usedRegister = factory.compare("data", RS_PROGRAM_STORAGE SEP MC_VARIABLE_VALUE(var.comp_info.varIndex), eq,
-                                                        RS_PROGRAM_STORAGE SEP MC_VARIABLE_VALUE(var2.comp_info.varIndex));
-
-                                break;
-                            }
-                            default:
-                                WARN("Unimplemented comparison.");
-                        }
+                        if (!err.empty()) return {};
+                        break;
                     }
-                    else
+                _parseif:
+                    RS_ASSERT_SIZE(size > 0);
+
+                    if (size == 1 && instruction.parameters.at(0)->index() == 0)
                     {
+                        // bool convertable if statement
+                        rbc_constant& _const = std::get<0>(*instruction.parameters.at(0));
+                        if (_const.val_type != token_type::INT_LITERAL)
                         {
-                        result_pair<sharedt<rbc_register>, rbc_constant> res = 
-                            commutativeVariantEquals<sharedt<rbc_register>, rbc_constant, rbc_value>(1, lhs, 0, rhs);
-                        if (res)
-                        {
-                            rbc_register& reg =   *res.i1;
-                            rbc_constant& con =   *res.i2;
-
-                            if (reg.operable)
-                            {
-                                usedRegister = factory.compare("score", MC_OPERABLE_REG(INS_L(STR(reg.id))), eq, con.val, true);
-                            }
-                            else
-                            {
-                                factory.create_and_push(MC_DATA_CMD_ID, MC_TEMP_STORAGE_SET_CONST(con.val));
-                                // TODO: fix to not have leading keywords!
-                                usedRegister = factory.compare("data", MC_NOPERABLE_REG_GET(reg.id), eq, MC_TEMP_STORAGE);
-                            }
-                            goto _end;
-                        }
+                            // todo move error to torbc
+                            err = std::format("Cannot convert typeid {} to boolean.", static_cast<int>(_const.val_type));
+                            return {};
                         }
-                        {
-                        result_pair<sharedt<rbc_register>, sharedt<rs_variable>> res = 
-                            commutativeVariantEquals<sharedt<rbc_register>, sharedt<rs_variable>, rbc_value>(1, lhs, 2, rhs);
+                        const int value = std::stoi(_const.val);
 
-                        if (res)
+                        if (value == 0)
                         {
-                            rbc_register& reg = *res.i1;
-                            rs_variable&  var = *res.i2;
+                            // skip instructions contained
+                            while(++i < instructions.size())
+                            {
+                                auto& inst = instructions.at(i);
+                                if (inst.type == rbc_instruction::ELSE)
+                                    goto skip;
+                                if (inst.type == rbc_instruction::ENDIF)
+                                    break;
+                            }
 
-                            if (reg.operable)
-                                factory.getRegisterValue(reg).storeResult(PADR(storage) MC_TEMP_STORAGE, "int", 1);
-                            else
-                                factory.copyStorage(MC_TEMP_STORAGE, MC_NOPERABLE_REG_GET(reg.id));
-                            usedRegister = factory.compare("data", MC_VARIABLE_VALUE(var.comp_info.varIndex), eq, MC_TEMP_STORAGE);
-                            goto _end;
+                            i++; // skip ENDIF
                         }
-                        }
-                        {
-                        result_pair<sharedt<rs_variable>, rbc_constant> res = 
-                            commutativeVariantEquals<sharedt<rs_variable>, rbc_constant, rbc_value>(2, lhs, 0, rhs);
-
-                        if (res)
+                        else
                         {
-                            rs_variable&  var = *res.i1;
-                            rbc_constant& con = *res.i2;
-                            
-                            usedRegister = factory.compare("data", MC_VARIABLE_VALUE(var.comp_info.varIndex), eq, con.val, true);
-                            goto _end;
-                        }
+                        skip:
+                            // remove next end if and parse as normal
+                            size_t c = i;
+                            while(++c < instructions.size())
+                            {
+                                auto& inst = instructions.at(c);
+                                if(inst.type == rbc_instruction::ENDIF)
+                                {
+                                    instructions.erase(instructions.begin() + c);
+                                    break;
+                                }
+                            }
                         }
+                        break;
                     }
-                _end:
+                    std::shared_ptr<comparison_register> usedRegister = condition(instruction);
+                    if (!err.empty()) return {};
+
                     mcprogram.blocks.push({0, usedRegister});
                     break;
                 }
@@ -1916,8 +3330,8 @@ mc_program tomc(rbc_program& program, const std::string& moduleName, std::string
 
                     mcprogram.blocks.pop();
                     
-                    // we have an elif
-                    if (mcprogram.blocks.size() > 0 && mcprogram.blocks.top().first == 2)
+                    // we have an elif, every elif of the chain left a marker.
+                    while (mcprogram.blocks.size() > 0 && mcprogram.blocks.top().first == 2)
                         mcprogram.blocks.pop();
                     break;
                 }
@@ -1978,6 +3392,31 @@ mc_program tomc(rbc_program& program, const std::string& moduleName, std::string
                         factory.Return(false);
                     break;
                 }
+                case rbc_instruction::LOOP:
+                case rbc_instruction::FOR:
+                {
+                    lowerLoop(instructions, i);
+                    if (!err.empty()) return {};
+                    break;
+                }
+                case rbc_instruction::BREAK:
+                {
+                    RS_ASSERTC(!loops.empty(), "Break outside of a loop. This error is a bug, flag it on github.");
+                    if (!loops.back().broken.empty())
+                    {
+                        mc_command flag{false, MC_RAW_CMD_ID, loops.back().broken};
+                        factory.add(flag);
+                    }
+                    factory.create_and_push(MC_RETURN_CMD_ID, "0");
+                    break;
+                }
+                case rbc_instruction::CONTINUE:
+                {
+                    RS_ASSERTC(!loops.empty(), "Continue outside of a loop. This error is a bug, flag it on github.");
+                    mc_command next{false, MC_RAW_CMD_ID, loops.back().next};
+                    factory.add(next);
+                    break;
+                }
                 case rbc_instruction::SAVERET:
                 {
                     RS_ASSERT_SIZE(size == 1);
@@ -1988,6 +3427,110 @@ mc_program tomc(rbc_program& program, const std::string& moduleName, std::string
                     factory.copyStorage(MC_VARIABLE_TYPE(var.comp_info.varIndex) , RS_PROGRAM_RETURN_TYPE_REGISTER);
                     break;
                 }
+                case rbc_instruction::CAST:
+                {
+                    RS_ASSERT_SIZE(size == 2 || size == 3);
+
+                    rs_variable& var = *std::get<2>(*instruction.parameters.at(0));
+                    rs_object& type  = *std::get<3>(*instruction.parameters.at(1));
+                    const std::string from = size == 3 ? MC_VARIABLE_VALUE(std::get<2>(*instruction.parameters.at(2))->comp_info.varIndex)
+                                                       : RS_PROGRAM_RETURN_REGISTER;
+                    factory.castObject(var, from, type);
+                    break;
+                }
+                case rbc_instruction::INDEX:
+                {
+                    RS_ASSERT_SIZE(size == 3);
+
+                    rs_variable& var  = *std::get<2>(*instruction.parameters.at(0));
+                    rs_variable& list = *std::get<2>(*instruction.parameters.at(1));
+                    auto read = [&](const std::string& element)
+                    { return factory.makeCopyStorage(MC_VARIABLE_VALUE(var.comp_info.varIndex), element); };
+                    // a missing key leaves the variable as it was.
+                    if (list.type_info.isMap())
+                        mapEntry(list, *instruction.parameters.at(2), [&](const std::string& entry, const std::string&)
+                                 { return mccmdlist{read(entry)}; });
+                    else
+                        listElement(list, *instruction.parameters.at(2), read);
+                    break;
+                }
+                case rbc_instruction::SETINDEX:
+                {
+                    RS_ASSERT_SIZE(size == 3);
+
+                    rs_variable& list = *std::get<2>(*instruction.parameters.at(0));
+                    rbc_value& value  = *instruction.parameters.at(2);
+                    auto write = [&](const std::string& element) -> mc_command
+                    {
+                        switch (value.index())
+                        {
+                            case 0:
+                            {
+                                rbc_constant& c = std::get<0>(value);
+                                c.quoteIfStr();
+                                return mc_command(false, MC_DATA_CMD_ID, MC_DATA(modify storage, INS(element)) PAD(set value) INS_L(c.val));
+                            }
+                            case 1:
+                            {
+                                rbc_register& reg = *std::get<1>(value);
+                                if (reg.operable)
+                                    return factory.getRegisterValue(reg).storeResult(PADR(storage) RS_PROGRAM_STORAGE SEP + element, "int", 1);
+                                return factory.makeCopyStorage(element, ARR_AT(RS_PROGRAM_REGISTERS, STR(reg.id)));
+                            }
+                            default:
+                                return factory.makeCopyStorage(element, MC_VARIABLE_VALUE(std::get<2>(value)->comp_info.varIndex));
+                        }
+                    };
+                    if (!list.type_info.isMap())
+                    {
+                        listElement(list, *instruction.parameters.at(1), write);
+                        break;
+                    }
+                    // a new key is added to the keys the map is iterated by.
+                    const std::string path = MC_VARIABLE_VALUE(list.comp_info.varIndex);
+                    mapEntry(list, *instruction.parameters.at(1), [&](const std::string& entry, const std::string& key)
+                    {
+                        return mccmdlist{
+                            mc_command{false, MC_RAW_CMD_ID, "execute unless data storage " RS_PROGRAM_STORAGE SEP + entry
+                                                           + " run data modify storage " RS_PROGRAM_STORAGE SEP + MC_MAP_KEYS(path) + " append value " + MC_MAP_KEY_ENTRY(key)},
+                            write(entry)
+                        };
+                    });
+                    break;
+                }
+                case rbc_instruction::HASKEY:
+                {
+                    RS_ASSERT_SIZE(size == 3);
+
+                    rs_variable& var = *std::get<2>(*instruction.parameters.at(0));
+                    rs_variable& map = *std::get<2>(*instruction.parameters.at(1));
+                    mapEntry(map, *instruction.parameters.at(2), [&](const std::string& entry, const std::string&)
+                    {
+                        return mccmdlist{mc_command{false, MC_RAW_CMD_ID, "execute store result storage " MC_VARIABLE_VALUE_FULL(var.comp_info.varIndex)
+                                                                        " int 1 if data storage " RS_PROGRAM_STORAGE SEP + entry}};
+                    });
+                    break;
+                }
+                case rbc_instruction::DELKEY:
+                {
+                    RS_ASSERT_SIZE(size == 1 || size == 2);
+
+                    rs_variable& map = *std::get<2>(*instruction.parameters.at(0));
+                    const std::string path = MC_VARIABLE_VALUE(map.comp_info.varIndex);
+                    if (size == 1)
+                    {
+                        factory.create_and_push(MC_DATA_CMD_ID, MC_DATA(modify storage, INS(path)) PAD(set value) MC_MAP_EMPTY);
+                        break;
+                    }
+                    mapEntry(map, *instruction.parameters.at(1), [&](const std::string& entry, const std::string& key)
+                    {
+                        return mccmdlist{
+                            mc_command{false, MC_RAW_CMD_ID, "data remove storage " RS_PROGRAM_STORAGE SEP + entry},
+                            mc_command{false, MC_RAW_CMD_ID, "data remove storage " RS_PROGRAM_STORAGE SEP + MC_MAP_KEY(path, key)}
+                        };
+                    });
+                    break;
+                }
                 default:
                     WARN("Unimplemented RBC instruction found.");
                     break;
@@ -1998,8 +3541,135 @@ mc_program tomc(rbc_program& program, const std::string& moduleName, std::string
         return list;
     };
     
+    // splits an async function at its yields. the first part is the function itself, every other part is a
+    // generated function scheduled by the part before it. callers pop the variable stack once the first part
+    // returns, so live locals are copied out before scheduling, and back into their slots when resuming.
+    auto compileAsync = [&](rbc_function& function, mc_function& out)
+    {
+        std::vector<std::vector<rbc_command>> segments(1);
+        std::vector<std::string> delays;
+        for (rbc_command& inst : function.instructions)
+        {
+            if (inst.type == rbc_instruction::YIELD)
+            {
+                delays.push_back(std::get<0>(*inst.parameters.at(0)).val);
+                segments.emplace_back();
+                continue;
+            }
+            segments.back().push_back(inst);
+        }
+        // locals are created in the first part, so they have the same slot in every part.
+        std::vector<rbc_command> creates;
+        for (size_t k = 1; k < segments.size(); k++)
+        {
+            std::vector<rbc_command> segment;
+            for (rbc_command& inst : segments.at(k))
+            {
+                if (inst.type != rbc_instruction::CREATE)
+                {
+                    segment.push_back(inst);
+                    continue;
+                }
+                rbc_command create(rbc_instruction::CREATE);
+                create.parameters = {inst.parameters.at(0)};
+                creates.push_back(create);
+                if (inst.parameters.size() > 1)
+                {
+                    rbc_command set(rbc_instruction::SAVE);
+                    set.parameters = inst.parameters;
+                    segment.push_back(set);
+                }
+            }
+            segments.at(k) = segment;
+        }
+        segments.front().insert(segments.front().begin(), creates.begin(), creates.end());
+
+        std::vector<mccmdlist> parts;
+        for (auto& segment : segments)
+        {
+            parts.push_back(parseFunction(segment));
+            if (!err.empty())
+                return;
+        }
+
+        auto local = [&](rs_variable* var)
+        {
+            return std::any_of(function.localVariables.begin(), function.localVariables.end(),
+                               [&](auto& entry) { return entry.second.first.get() == var; });
+        };
+        auto raw = [](const std::string& body) { return mc_command{false, MC_RAW_CMD_ID, body}; };
+        const std::string id = util::hashToHex(util::stableHash(out.location(moduleName)));
+        const std::string state = RS_PROGRAM_STORAGE SEP RS_PROGRAM_DATA ".async.f" + id;
+
+        std::vector<mc_function> resumes;
+        for (size_t k = 1; k < parts.size(); k++)
+        {
+            // live: locals of this function used by any later part.
+            std::vector<rs_variable*> live;
+            for (size_t later = k; later < segments.size(); later++)
+                for (rbc_command& inst : segments.at(later))
+                    for (auto& param : inst.parameters)
+                        if (param->index() == 2)
+                        {
+                            rs_variable* var = std::get<2>(*param).get();
+                            if (local(var) && std::find(live.begin(), live.end(), var) == live.end())
+                                live.push_back(var);
+                        }
+            std::sort(live.begin(), live.end(), [](rs_variable* a, rs_variable* b)
+                      { return a->comp_info.varIndex < b->comp_info.varIndex; });
+
+            mc_function resume;
+            resume.name = id + '_' + std::to_string(k);
+            resume.modulePath = {MC_GENERATED_FOLDER};
+            resume.generated = true;
+
+            mccmdlist& before = parts.at(k - 1);
+            if (!live.empty())
+            {
+                // every pending call has its own entry, resumed in the order they were scheduled in.
+                const std::string queue = state + ".p" + std::to_string(k);
+                before.push_back(raw("data modify storage " + queue + " append value []"));
+                for (rs_variable* var : live)
+                    before.push_back(raw("data modify storage " + queue + "[-1] append from storage " RS_PROGRAM_STORAGE SEP
+                                         ARR_AT(RS_PROGRAM_VARIABLES, STR(var->comp_info.varIndex))));
+                // the stack can be shorter on the tick we resume in, it is padded up to the highest live slot.
+                for (int slot = 0; slot <= live.back()->comp_info.varIndex; slot++)
+                    resume.commands.push_back(raw("execute unless data storage " RS_PROGRAM_STORAGE SEP
+                                                  ARR_AT(RS_PROGRAM_VARIABLES, STR(slot)) +
+                                                  " run data modify storage " RS_PROGRAM_STORAGE SEP RS_PROGRAM_VARIABLES " append value {}"));
+                for (size_t n = 0; n < live.size(); n++)
+                    resume.commands.push_back(raw("data modify storage " RS_PROGRAM_STORAGE SEP
+                                                  ARR_AT(RS_PROGRAM_VARIABLES, STR(live.at(n)->comp_info.varIndex)) +
+                                                  " set from storage " + queue + "[0][" + std::to_string(n) + ']'));
+                resume.commands.push_back(raw("data remove storage " + queue + "[0]"));
+            }
+            // append, so a call made before an earlier one resumed doesn't replace it.
+            before.push_back(raw("schedule function " + resume.location(moduleName) + ' ' + delays.at(k - 1) + "t append"));
+
+            resumes.push_back(std::move(resume));
+        }
+        // a part is only complete once the next one has saved its state and scheduled it.
+        for (size_t k = 1; k < parts.size(); k++)
+        {
+            mc_function& resume = resumes.at(k - 1);
+            resume.commands.insert(resume.commands.end(), parts.at(k).begin(), parts.at(k).end());
+            mcprogram.functions.push_back(std::move(resume));
+        }
+        out.commands = parts.front();
+    };
+
     // try{
+        compiling = RS_GLOBAL_SOURCE_NAME;
         mcprogram.globalFunction.commands = parseFunction(program.globalFunction.instructions);
+        mcprogram.globalFunction.source = RS_GLOBAL_SOURCE_NAME;
+        // functions generated while compiling a function are attributed to it.
+        auto attribute = [&](size_t from, const std::string& source)
+        {
+            for (size_t k = from; k < mcprogram.functions.size(); k++)
+                if (mcprogram.functions[k].source.empty())
+                    mcprogram.functions[k].source = source;
+        };
+        attribute(0, RS_GLOBAL_SOURCE_NAME);
 
         std::vector<std::shared_ptr<rbc_function>> allFunctions;
 
@@ -2023,7 +3693,8 @@ mc_program tomc(rbc_program& program, const std::string& moduleName, std::string
             // do search to get all module functions
             while (!modules.empty())
             {
-                auto& mod = modules.top();
+                std::shared_ptr<rs_module> mod = modules.top();
+                modules.pop();
                 auto& newFunctions = mod->functions;
                 if (newFunctions.size() > 0)
                 {
@@ -2039,8 +3710,6 @@ mc_program tomc(rbc_program& program, const std::string& moduleName, std::string
 
                 for(auto& child : mod->children)
                     modules.push(child.second);
-
-                modules.pop();
             }
         }
 
@@ -2053,10 +3722,22 @@ mc_program tomc(rbc_program& program, const std::string& moduleName, std::string
                 std::find(decorators.begin(), decorators.end(), rbc_function_decorator::EXTERN) == decorators.end()
             ) // not inbuilt function 
             {
-                mc_function f{function->name,
-                              parseFunction(function->instructions),
-                              function->modulePath};
+                mc_function f{function->name, {}, function->modulePath};
                 f.parentalHashStr = function->getParentHashStr();
+                f.budget = function->budget;
+                f.source = function->name;
+                for (auto parent = function->parent; parent; parent = parent->parent)
+                    f.source = parent->name + '.' + f.source;
+                for (auto _module = function->modulePath.rbegin(); _module != function->modulePath.rend(); ++_module)
+                    f.source = *_module + "::" + f.source;
+
+                const size_t generatedFrom = mcprogram.functions.size();
+                compiling = f.source;
+                if (std::find(decorators.begin(), decorators.end(), rbc_function_decorator::ASYNC) != decorators.end())
+                    compileAsync(*function, f);
+                else
+                    f.commands = parseFunction(function->instructions);
+                attribute(generatedFrom, f.source);
                 mcprogram.functions.push_back(f);
             }
         }
@@ -2065,10 +3746,57 @@ mc_program tomc(rbc_program& program, const std::string& moduleName, std::string
     //     err = std::string("Internal error: ") + e.what();
     //     return mcprogram;
     // }
+    factory.origin = {};
     factory.initProgram();
     mccmdlist init = factory.package();
     mcprogram.globalFunction.commands.insert(mcprogram.globalFunction.commands.begin(), init.begin(), init.end());
 
+    if (RS_CONFIG.getOr<int>("cache_selectors", 1))
+    {
+        optimization::selector_cache_options options;
+        options.minUses = std::max(2, RS_CONFIG.getOr<int>("cache_selectors_min_uses", options.minUses));
+        optimization::cacheSelectors(mcprogram, options);
+    }
+    if (RS_CONFIG.getOr<int>("dedupe", 1))
+        optimization::dedupe(mcprogram, moduleName);
+    if (RS_CONFIG.getOr<int>("outline", 1))
+    {
+        optimization::outline_options options;
+        const int minLength  = RS_CONFIG.getOr<int>("outline_min_length", options.minLength);
+        const int maxLength  = RS_CONFIG.getOr<int>("outline_max_length", options.maxLength);
+        options.callCost     = RS_CONFIG.getOr<int>("outline_call_cost", options.callCost);
+        options.functionCost = RS_CONFIG.getOr<int>("outline_function_cost", options.functionCost);
+        options.minGain      = RS_CONFIG.getOr<int>("outline_min_gain", options.minGain);
+        // the lengths are sizes, a negative one would wrap around.
+        if (minLength < 2 || maxLength < minLength)
+        {
+            err = "Config error: 'outline_min_length' must be at least 2, and 'outline_max_length' at least 'outline_min_length'.";
+            return mcprogram;
+        }
+        if (options.callCost < 0 || options.functionCost < 0 || options.minGain < 0)
+        {
+            err = "Config error: 'outline_call_cost', 'outline_function_cost' and 'outline_min_gain' can't be negative.";
+            return mcprogram;
+        }
+        options.minLength = static_cast<size_t>(minLength);
+        options.maxLength = static_cast<size_t>(maxLength);
+        if (profile)
+        {
+            // a helper call costs a command every time it runs: hot code is left as is. generated functions
+            // are as hot as the line they start on.
+            options.keep = [profile](const mc_function& function)
+            {
+                if (!function.generated)
+                    return profile->of(function.source) == pgo::heat::HOT;
+                for (const mc_command& command : function.commands)
+                    if (command.origin.line)
+                        return profile->of(function.source, command.origin.line) == pgo::heat::HOT;
+                return false;
+            };
+        }
+        optimization::outline(mcprogram, moduleName, options);
+    }
+
     return mcprogram;
 }
 namespace conversion
@@ -2176,11 +3904,80 @@ namespace conversion
                 create_and_push(MC_DATA_CMD_ID, MC_VARIABLE_SET_CONST(var.comp_info.varIndex, c.val));
                 break;
             }
+            // register
+            case 1:
+            {
+                rbc_register& reg = *std::get<1>(val);
+                if (reg.operable)
+                    add( getRegisterValue(reg).storeResult(PADR(storage) MC_VARIABLE_VALUE_FULL(var.comp_info.varIndex), "int", 1) );
+                else
+                    copyStorage(MC_VARIABLE_VALUE(var.comp_info.varIndex), ARR_AT(RS_PROGRAM_REGISTERS, STR(reg.id)));
+                break;
+            }
+            // variable
+            case 2:
+            {
+                rs_variable& other = *std::get<2>(val);
+                copyStorage(MC_VARIABLE_VALUE(var.comp_info.varIndex), MC_VARIABLE_VALUE(other.comp_info.varIndex));
+                break;
+            }
+            // list
+            case 4:
+            {
+                std::vector<mc_command> patches;
+                std::string literal = listLiteral(*std::get<4>(val), var.type_info.element_type(), MC_VARIABLE_VALUE(var.comp_info.varIndex), patches);
+                create_and_push(MC_DATA_CMD_ID, MC_VARIABLE_SET_CONST(var.comp_info.varIndex, literal));
+                for (auto& cmd : patches) add(cmd);
+                break;
+            }
             default:
                 ERROR("Unsupported SAVE operation. TODO implement!");
         }
         return THIS;
     }
+    CommandFactory::_This CommandFactory::castObject       (rs_variable& var, const std::string& from, rs_object& type)
+    {
+        const std::string to = MC_VARIABLE_VALUE(var.comp_info.varIndex);
+        std::string source = from;
+        // the object is rebuilt in place, so a variable cast onto itself is read from a copy.
+        if (source == to)
+        {
+            copyStorage(MC_TEMP_STORAGE_NAME, source);
+            source = MC_TEMP_STORAGE_NAME;
+        }
+        // by name, so a type always lowers to the same commands.
+        std::map<std::string, rs_object::_MemberT*> members;
+        for (auto& [name, member] : type.members)
+            members.insert({name, &member});
+
+        // defaults go in the literal the object starts as, members read from the source overwrite them.
+        std::string literal = "{";
+        for (auto& [name, member] : members)
+        {
+            if (member->second == rs_object_member_decorator::REQUIRED)
+                continue;
+            const std::string value = memberDefault(*member);
+            if (!value.empty())
+                literal += (literal.size() > 1 ? "," : "") + name + ':' + value;
+        }
+        literal += '}';
+        create_and_push(MC_DATA_CMD_ID, MC_DATA(modify storage, INS(to)) PAD(set value) INS_L(literal));
+
+        // seperate members aren't part of the source, they keep their default.
+        for (auto& [name, member] : members)
+            if (member->second != rs_object_member_decorator::SEPERATE)
+                copyStorage(to + '.' + name, source + '.' + name);
+        // a source without a required member makes the cast null.
+        for (auto& [name, member] : members)
+        {
+            if (member->second != rs_object_member_decorator::REQUIRED)
+                continue;
+            mc_command missing(false, MC_DATA_CMD_ID, MC_DATA(modify storage, INS(to)) PAD(set value) "0");
+            missing.ifcmp("storage", comparison_operation_type::EQ, RS_PROGRAM_STORAGE SEP + source + '.' + name, true);
+            add(missing);
+        }
+        return THIS;
+    }
     CommandFactory::_This CommandFactory::setRegisterValue (rbc_register& reg, rbc_value& value)
     {
         switch(value.index())
@@ -2198,7 +3995,15 @@ namespace conversion
             }
             case 1:
             {
-                // TODO
+                rbc_register& other = *std::get<1>(value);
+                if (reg.operable && other.operable)
+                    create_and_push(MC_SCOREBOARD_CMD_ID, MC_REG_OPERATE(reg.id, "=", other.id));
+                else if (reg.operable)
+                    add(getRegisterValue(other).storeResult(PADR(score) MC_OPERABLE_REG(INS_L(STR(reg.id)))));
+                else if (other.operable)
+                    add(getRegisterValue(other).storeResult(PADR(storage) RS_PROGRAM_STORAGE SEP ARR_AT(RS_PROGRAM_REGISTERS, STR(reg.id)), "int", 1));
+                else
+                    copyStorage(ARR_AT(RS_PROGRAM_REGISTERS, STR(reg.id)), ARR_AT(RS_PROGRAM_REGISTERS, STR(other.id)));
                 break;
             }
             case 2:
@@ -2368,9 +4173,71 @@ namespace conversion
                                             SEP
                                         MC_DATA(set from storage, INS_L(src)));
     }
+    std::string           CommandFactory::listLiteral      (rs_list& list, rs_type_info element, const std::string& at, std::vector<mc_command>& patches)
+    {
+        std::string literal = "[";
+        for (size_t i = 0; i < list.values.size(); i++)
+        {
+            rbc_value& value = *list.values.at(i);
+            const std::string slot = at + '[' + STR(i) + ']';
+            if (i)
+                literal += ',';
+            switch(value.index())
+            {
+                case 0:
+                {
+                    rbc_constant& c = std::get<0>(value);
+                    literal += c.val_type == token_type::STRING_LITERAL ? c.quoted() : c.val;
+                    continue;
+                }
+                case 4:
+                    literal += listLiteral(*std::get<4>(value), element.element_type(), slot, patches);
+                    continue;
+                case 1:
+                {
+                    rbc_register& reg = *std::get<1>(value);
+                    // stored as the tag type of the placeholder below, float literals are doubles.
+                    if (reg.operable)
+                        patches.push_back(getRegisterValue(reg).storeResult(PADR(storage) RS_PROGRAM_STORAGE SEP INS_L(slot),
+                                                                            element.type_id == RS_FLOAT_KW_ID && !element.array_count ? "double" : "int", 1));
+                    else
+                        patches.push_back(makeCopyStorage(slot, ARR_AT(RS_PROGRAM_REGISTERS, STR(reg.id))));
+                    break;
+                }
+                case 2:
+                    patches.push_back(makeCopyStorage(slot, MC_VARIABLE_VALUE(std::get<2>(value)->comp_info.varIndex)));
+                    break;
+                default:
+                    ERROR("A list element can't be %s, only a constant, variable, expression or list.",
+                          value.index() == 3 ? "an object literal" : "a function");
+                    break;
+            }
+            // a placeholder of the element's type, lists only hold one type of tag.
+            if (element.array_count)
+                literal += "[]";
+            else if (element.type_id == RS_STRING_KW_ID)
+                literal += "\"\"";
+            else if (element.type_id == RS_FLOAT_KW_ID)
+                literal += "0.0";
+            else if (element.isMap() || element.type_id == RS_OBJECT_KW_ID || element.type_id >= static_cast<int32_t>(rs_object::TYPE_CARET_START))
+                literal += "{}";
+            else
+                literal += '0';
+        }
+        return literal + ']';
+    }
     CommandFactory::_This CommandFactory::createVariable   (rs_variable& var)
     {
-        create_and_push(MC_DATA_CMD_ID,
+        // maps start empty rather than at 0.
+        if (var.type_info.isMap())
+            create_and_push(MC_DATA_CMD_ID,
+                MC_DATA(modify storage, RS_PROGRAM_VARIABLES)
+                    PAD(append value)
+                MC_VARIABLE_JSON(MC_MAP_EMPTY, std::to_string(var.scope),
+                                               std::to_string(var.type_info.type_id))
+                        );
+        else
+            create_and_push(MC_DATA_CMD_ID,
                 MC_DATA(modify storage, RS_PROGRAM_VARIABLES)
                     PAD(append value)
                 MC_VARIABLE_JSON_DEFAULT(std::to_string(var.scope),
@@ -2422,77 +4289,19 @@ namespace conversion
             }
             case 4:
             {
-                //  0, 1, 2, 3
-                // v = [4, x, 4, y]
-
-                rs_list& l = *std::get<4>(val);
-
-                std::stringstream listInitStr;
-                listInitStr << '[';
-
-                std::vector<uint32_t> uninitialized;
-                std::vector<mc_command> initCommands;
-                for(auto& value : l.values)
-                {
-                    switch(value->index())
-                    {
-                        case 0:
-                        {
-                            rbc_constant& c = std::get<0>(*value);
-                            c.quoteIfStr();
-
-                            listInitStr << c.val << ',';
-
-                            break;
-                        }
-                        case 1:
-                        {
-                            rbc_register& reg = *std::get<1>(*value);
-                            
-                            if(reg.operable)
-                            {
-                                mc_command assign(false, MC_DATA_CMD_ID, MC_DATA(modify storage, MC_VARIABLE_VALUE(var.comp_info.varIndex))
-                                                        PAD(append from score) MC_OPERABLE_REG(INS_L(STR(reg.id)))
-                                                );
-                                initCommands.push_back(assign);
-
-                            }
-                            else
-                            {
-                                // TODO FIX
-                                mc_command assign(false, MC_DATA_CMD_ID, MC_DATA(modify storage, MC_VARIABLE_VALUE(var.comp_info.varIndex))
-                                                        PAD(append from storage) MC_NOPERABLE_REG(reg.id)
-                                            );
-                                initCommands.push_back(assign);
-                            }
-                            break;
-                        }
-                        case 2:
-                        {
-                            // insert 0, and append (move code to below).
-                            rs_variable& v = *std::get<2>(*value);
+                var.comp_info.varIndex = context.varStackCount++;
 
-                            mc_command assign(false, MC_DATA_CMD_ID, MC_DATA(modify storage, MC_VARIABLE_VALUE(var.comp_info.varIndex))
-                                                        PAD(append from storage) MC_VARIABLE_VALUE_FULL(v.comp_info.varIndex)
-                                            );
-                            initCommands.push_back(assign);
-                            break;
-                        }
-                    }
-                }
-                listInitStr.seekp(-1, std::ios_base::end);
-                listInitStr << ']';
+                // the whole literal is written at once, non-constant elements are patched in afterwards.
+                std::vector<mc_command> patches;
+                std::string literal = listLiteral(*std::get<4>(val), var.type_info.element_type(), MC_VARIABLE_VALUE(var.comp_info.varIndex), patches);
 
                 create_and_push(MC_DATA_CMD_ID,
                     MC_DATA(modify storage, RS_PROGRAM_VARIABLES)
                         PAD(append value)
-                    MC_VARIABLE_JSON_VAL(listInitStr.str(), std::to_string(var.scope),
+                    MC_VARIABLE_JSON_VAL(literal, std::to_string(var.scope),
                                                 std::to_string(var.type_info.type_id))
                                 );
-
-                // add all commands after we init
-                for (auto& cmd : initCommands) add(cmd);
-
+                for (auto& cmd : patches) add(cmd);
                 break;
             }
         }
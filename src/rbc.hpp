@@ -45,7 +45,20 @@ enum class rbc_instruction
     PUSH,
     POP,
     INC, // inc scope
-    DEC  // dec scope
+    DEC, // dec scope
+
+    LOOP,    // start of a while loop, its condition is computed between this and WHILE
+    WHILE,   // condition of a while loop, same parameters as IF
+    FOR,     // range loop: variable, from, to (exclusive). with only a selector, runs as and at every entity it finds
+    ENDLOOP,
+    BREAK,
+    CONTINUE,
+    YIELD,   // <ticks>, only at the top level of an async function
+    CAST,    // <variable>, <object type>[, <variable>]: projects the variable, or the return register, onto the type
+    INDEX,   // <variable>, <list>, <index>: sets the variable to the element of the list at the index, or of the map under the key
+    SETINDEX,// <list>, <index>, <value>: sets the element of the list at the index, or of the map under the key
+    HASKEY,  // <variable>, <map>, <key>: sets the variable to 1 if the map has the key, 0 otherwise
+    DELKEY   // <map>[, <key>]: removes the key from the map, or every key without one
 };
 enum class rbc_scope_type
 {
@@ -54,6 +67,7 @@ enum class rbc_scope_type
     ELSE,
     FUNCTION,
     MODULE,
+    LOOP,
     NONE
 };
 
@@ -79,6 +93,8 @@ enum class rbc_function_decorator
     NOCOMPILE,
     NORETURN,
     WRAPPER,
+    ASYNC,   // split at yield points, the rest of the function runs on later ticks.
+    BUDGET,  // budget(n), the build fails if the function can run more than n commands in a tick.
     UNKNOWN
 };
 
@@ -140,6 +156,8 @@ struct rbc_command
 {
     rbc_instruction type;
     std::vector<std::shared_ptr<rbc_value>> parameters;
+    // statement the instruction was compiled from, stamped by rbc_program.
+    source_location origin;
 
     template<typename... _RBCValues>
     rbc_command(rbc_instruction _type, _RBCValues&&... values)
@@ -176,6 +194,8 @@ struct rbc_function
     std::unordered_map<std::string, std::shared_ptr<rbc_function>> childFunctions;
 
     bool hasBody = true;
+    // set by the budget decorator, -1 for none.
+    int budget = -1;
 
     rs_variable* getNthParameter(size_t p);
     rs_variable* getParameterByName(const std::string& name);
@@ -207,6 +227,8 @@ struct rbc_program
     std::vector<std::shared_ptr<rbc_register>> registers;
     raw_rbc_function globalFunction;
     rbc_scope_type lastScope;
+    // start of the statement being compiled, instructions added without an origin get this one.
+    source_location origin;
 public:
     sharedt<rs_variable> getVariable(const std::string& name);
     sharedt<rbc_register> getFreeRegister(bool operable = false);
@@ -247,10 +269,19 @@ namespace rbc_commands
         rbc_command create(std::shared_ptr<rs_variable> v);
         rbc_command storeReturn(std::shared_ptr<rs_variable> v);
         rbc_command set(std::shared_ptr<rs_variable> v, rbc_value val);
+        // from the return register if from is null.
+        rbc_command cast(std::shared_ptr<rs_variable> v, std::shared_ptr<rs_object> type, std::shared_ptr<rs_variable> from = nullptr);
+        rbc_command index(std::shared_ptr<rs_variable> v, std::shared_ptr<rs_variable> list, rbc_value index);
+        rbc_command setIndex(std::shared_ptr<rs_variable> list, rbc_value index, rbc_value val);
+        rbc_command hasKey(std::shared_ptr<rs_variable> v, std::shared_ptr<rs_variable> map, rbc_value key);
+        rbc_command removeKey(std::shared_ptr<rs_variable> map, rbc_value key);
+        rbc_command removeKey(std::shared_ptr<rs_variable> map);
     };
 };
+class lex_cache;
+// cache, if given, is used to read and lex every file used.
 void preprocess(token_list&, std::string, std::string&, rs_error*,
-                std::shared_ptr<std::vector<std::filesystem::path>> = nullptr);
+                std::shared_ptr<std::vector<std::filesystem::path>> = nullptr, lex_cache* cache = nullptr);
 rbc_program torbc(token_list&, std::string, std::string&, rs_error*);
 
 namespace conversion
@@ -270,6 +301,9 @@ namespace conversion
         
         
         _This op_reg_math(rbc_register& reg, rbc_value& val, bst_operation_type t);
+        // snbt for a list literal stored at 'at'. constants are written in place, every other element gets a
+        // placeholder and a command in patches that sets it.
+        std::string listLiteral(rs_list& list, rs_type_info element, const std::string& at, std::vector<mc_command>& patches);
         inline _This nop_reg_math(rbc_register&, rbc_value&, bst_operation_type)
         {
             WARN("Non operable register math is not supported.");
@@ -278,12 +312,16 @@ namespace conversion
     public:
 
         std::shared_ptr<mccmdlist> _buffer;
+        // the instruction being converted, commands added without an origin get this one.
+        source_location origin;
 
         CommandFactory(mc_program& _context, rbc_program& _rbc_compiler) : context(_context), rbc_compiler(_rbc_compiler)
         {}
         inline void add(mc_command& c)
         { 
             make(c);
+            if (!c.origin.line)
+                c.origin = origin;
             if (_useBuffer)
                 _buffer->push_back(c);
             else 
@@ -305,6 +343,17 @@ namespace conversion
         {
             commands.clear();
         }
+        // takes the unpackaged commands, so another function can be built with this factory.
+        inline mccmdlist detach()
+        {
+            mccmdlist detached = std::move(commands);
+            commands.clear();
+            return detached;
+        }
+        inline void attach(mccmdlist& detached)
+        {
+            commands = std::move(detached);
+        }
         inline void pop_back()
         {
             commands.pop_back();
@@ -353,6 +402,8 @@ namespace conversion
         static mc_command getStackValue   (long index);
         _This             setRegisterValue(rbc_register& reg, rbc_value& c);
         _This             setVariableValue(rs_variable& var, rbc_value& val);
+        // sets var to the members of type read from the storage path from, or to null if a required one is missing.
+        _This             castObject      (rs_variable& var, const std::string& from, rs_object& type);
     };
 }
 
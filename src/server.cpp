@@ -0,0 +1,308 @@
+#include "server.hpp"
+#include "logger.hpp"
+
+#ifdef _WIN32
+namespace server
+{
+    int serve(const std::vector<compiler::job>&, const options&)
+    {
+        ERROR("--serve is not supported on Windows yet, use --batch.");
+        return EXIT_FAILURE;
+    }
+}
+#else
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <unordered_map>
+#include <csignal>
+#include <cstring>
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace server
+{
+    static std::string normal(const std::filesystem::path& path)
+    {
+        return std::filesystem::absolute(path).lexically_normal().string();
+    }
+
+    // reports which of the tracked files changed. inotify on linux, modification times elsewhere.
+    class watcher
+    {
+    public:
+        watcher()
+        {
+#ifdef __linux__
+            _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+        }
+        ~watcher()
+        {
+            if (_fd >= 0)
+                close(_fd);
+        }
+        // descriptor to poll for changes, -1 if changes have to be polled for with check().
+        int fd() const { return _fd; }
+
+        void track(const std::string& file)
+        {
+            if (!_files.insert(file).second)
+                return;
+            std::error_code ec;
+            _times[file] = std::filesystem::last_write_time(file, ec);
+#ifdef __linux__
+            const std::string dir = std::filesystem::path(file).parent_path().string();
+            if (_fd < 0 || _dirs.count(dir))
+                return;
+            // files are often saved by writing a new file and renaming it over the old one,
+            // so the directory is watched rather than the file.
+            const int wd = inotify_add_watch(_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+            if (wd >= 0)
+            {
+                _dirs.insert(dir);
+                _watches[wd] = dir;
+            }
+#endif
+        }
+        // tracked files changed since the last call.
+        std::set<std::string> check()
+        {
+            std::set<std::string> changed;
+#ifdef __linux__
+            if (_fd >= 0)
+            {
+                alignas(inotify_event) char buffer[4096];
+                ssize_t length;
+                while ((length = read(_fd, buffer, sizeof(buffer))) > 0)
+                {
+                    for (char* at = buffer; at < buffer + length;)
+                    {
+                        auto* event = reinterpret_cast<inotify_event*>(at);
+                        at += sizeof(inotify_event) + event->len;
+                        auto dir = _watches.find(event->wd);
+                        if (dir == _watches.end() || event->len == 0)
+                            continue;
+                        const std::string file = normal(std::filesystem::path(dir->second) / event->name);
+                        if (_files.count(file) && touched(file))
+                            changed.insert(file);
+                    }
+                }
+                return changed;
+            }
+#endif
+            for (const std::string& file : _files)
+                if (touched(file))
+                    changed.insert(file);
+            return changed;
+        }
+
+    private:
+        // closing a file that was only opened also raises an event, so the modification time decides.
+        bool touched(const std::string& file)
+        {
+            std::error_code ec;
+            auto time = std::filesystem::last_write_time(file, ec);
+            if (time == _times[file])
+                return false;
+            _times[file] = time;
+            return true;
+        }
+
+        int _fd = -1;
+        std::set<std::string> _files, _dirs;
+        std::unordered_map<std::string, std::filesystem::file_time_type> _times;
+        std::unordered_map<int, std::string> _watches;
+    };
+
+    struct program
+    {
+        compiler::job    job;
+        compiler::result last;
+        mc_write_state   written;
+        double           ms = 0;
+        // one of its files changed, but it hasn't been rebuilt since.
+        bool             dirty = false;
+    };
+    static std::string describe(const program& p)
+    {
+        if (p.last.ok)
+            return "ok " + p.job.source + ' ' + std::to_string(static_cast<long long>(p.ms)) + ' ' +
+                   std::to_string(p.written.written) + ' ' + std::to_string(p.written.unchanged) + ' ' +
+                   std::to_string(p.written.removed) + '\n';
+        std::string message = p.last.error;
+        std::replace(message.begin(), message.end(), '\n', ' ');
+        return "error " + p.job.source + ' ' + (p.last.file.empty() ? p.job.source : p.last.file) + ':' +
+               std::to_string(p.last.line) + ':' + std::to_string(p.last.column) + ": " + message + '\n';
+    }
+
+    int serve(const std::vector<compiler::job>& jobs, const options& opts)
+    {
+        signal(SIGPIPE, SIG_IGN);
+
+        const int listener = socket(AF_INET, SOCK_STREAM, 0);
+        int yes = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in address{};
+        address.sin_family      = AF_INET;
+        address.sin_port        = htons(opts.port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, 8) < 0)
+        {
+            ERROR("Could not listen on 127.0.0.1:%d: %s", opts.port, std::strerror(errno));
+            return EXIT_FAILURE;
+        }
+
+        rs_context context = rs_context::current().fork();
+        watcher files;
+        std::vector<program> programs(jobs.size());
+        for (size_t j = 0; j < jobs.size(); j++)
+            programs[j].job = jobs[j];
+
+        auto build = [&](program& p)
+        {
+            auto start = std::chrono::steady_clock::now();
+            context.diagnostics.clear();
+            p.last  = compiler::compile(p.job, context, &p.written, opts.compile);
+            p.ms    = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            p.dirty = false;
+            for (const std::filesystem::path& file : p.last.files)
+                files.track(normal(file));
+            return describe(p);
+        };
+
+        std::vector<int> clients;
+        std::unordered_map<int, std::string> pending;
+        auto send = [&](int client, const std::string& text) { ::send(client, text.data(), text.size(), 0); };
+        auto broadcast = [&](const std::string& text)
+        {
+            for (int client : clients)
+                send(client, text);
+        };
+        // changes are only reported once, so every program using a changed file is marked before any is rebuilt.
+        auto mark = [&](const std::set<std::string>& changed)
+        {
+            for (const std::string& file : changed)
+                context.cache->invalidate(file);
+            for (program& p : programs)
+                for (const std::filesystem::path& file : p.last.files)
+                    p.dirty |= changed.count(normal(file)) > 0;
+        };
+        // rebuilds every dirty program, and tells the clients.
+        auto rebuildDirty = [&]()
+        {
+            std::string rebuilt;
+            for (program& p : programs)
+                if (p.dirty)
+                    rebuilt += build(p);
+            if (!rebuilt.empty())
+            {
+                printf("%s", rebuilt.c_str());
+                broadcast(rebuilt + "end\n");
+            }
+        };
+
+        std::string report;
+        for (program& p : programs)
+            report += build(p);
+        INFO("Serving %zu programs on 127.0.0.1:%d.", programs.size(), opts.port);
+        printf("%s", report.c_str());
+
+        bool running = true;
+        while (running)
+        {
+            std::vector<pollfd> fds = {{listener, POLLIN, 0}};
+            if (files.fd() >= 0)
+                fds.push_back({files.fd(), POLLIN, 0});
+            for (int client : clients)
+                fds.push_back({client, POLLIN, 0});
+
+            poll(fds.data(), fds.size(), files.fd() >= 0 ? -1 : opts.pollMs);
+
+            std::set<std::string> changed = files.check();
+            if (!changed.empty())
+            {
+                // let the rest of a save land before rebuilding.
+                usleep(opts.debounceMs * 1000);
+                std::set<std::string> more = files.check();
+                changed.insert(more.begin(), more.end());
+                mark(changed);
+                rebuildDirty();
+            }
+
+            if (fds[0].revents & POLLIN)
+            {
+                const int client = accept(listener, nullptr, nullptr);
+                if (client >= 0)
+                    clients.push_back(client);
+            }
+
+            for (size_t f = files.fd() >= 0 ? 2 : 1; f < fds.size(); f++)
+            {
+                if (!(fds[f].revents & (POLLIN | POLLHUP | POLLERR)))
+                    continue;
+                const int client = fds[f].fd;
+                char buffer[1024];
+                const ssize_t length = recv(client, buffer, sizeof(buffer), 0);
+                if (length <= 0)
+                {
+                    close(client);
+                    clients.erase(std::find(clients.begin(), clients.end(), client));
+                    pending.erase(client);
+                    continue;
+                }
+                std::string& input = pending[client];
+                input.append(buffer, length);
+
+                size_t newline;
+                while ((newline = input.find('\n')) != std::string::npos)
+                {
+                    std::string line = input.substr(0, newline);
+                    input.erase(0, newline + 1);
+                    if (!line.empty() && line.back() == '\r')
+                        line.pop_back();
+
+                    const size_t space = line.find(' ');
+                    const std::string command = line.substr(0, space);
+                    const std::string argument = space == std::string::npos ? "" : line.substr(space + 1);
+
+                    std::string reply;
+                    if (command == "build")
+                    {
+                        // programs this doesn't build keep their changes, and are rebuilt below.
+                        mark(files.check());
+                        for (program& p : programs)
+                            if (argument.empty() || p.job.source == argument)
+                                reply += build(p);
+                    }
+                    else if (command == "status")
+                    {
+                        for (const program& p : programs)
+                            reply += describe(p);
+                    }
+                    else if (command == "quit")
+                    {
+                        send(client, "bye\n");
+                        running = false;
+                        break;
+                    }
+                    else
+                        reply = "unknown " + command + '\n';
+                    send(client, reply + "end\n");
+                }
+            }
+            rebuildDirty();
+        }
+        for (int client : clients)
+            close(client);
+        close(listener);
+        return EXIT_SUCCESS;
+    }
+}
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include "compiler.hpp"
+
+// rscript --serve: compiles programs once, then rebuilds them whenever one of their files is saved.
+//
+// clients connect over tcp on localhost and send one command per line:
+//   build [entry]   rebuild every program, or only entry
+//   status          results of the last build of every program
+//   quit            stop the server
+// every reply, and every rebuild started by a file change, is sent as one line per program
+// followed by 'end'. programs with changed files that 'build entry' leaves out are rebuilt right after it:
+//   ok <entry> <ms> <files written> <files unchanged> <files removed>
+//   error <entry> <file>:<line>:<column>: <message>
+namespace server
+{
+    struct options
+    {
+        unsigned short port = 7878;
+        // file changes this close together are rebuilt once, editors often save in several steps.
+        int debounceMs      = 50;
+        // how often files are checked where there is no inotify.
+        int pollMs          = 500;
+        // passed to every compile.
+        compiler::options compile;
+    };
+    // runs until a client sends 'quit', returns the exit code.
+    int serve(const std::vector<compiler::job>& jobs, const options& opts);
+}
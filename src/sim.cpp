@@ -0,0 +1,1183 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include "sim.hpp"
+
+namespace sim
+{
+#pragma region nbt
+    nbt nbt::ofInt(long long value, nbt_type type)
+    {
+        nbt n;
+        n.type    = type;
+        n.integer = value;
+        n.real    = static_cast<double>(value);
+        return n;
+    }
+    nbt nbt::ofString(const std::string& value)
+    {
+        nbt n;
+        n.type = nbt_type::STRING;
+        n.text = value;
+        return n;
+    }
+    bool nbt::numeric() const
+    {
+        return type != nbt_type::STRING && type != nbt_type::LIST && type != nbt_type::COMPOUND;
+    }
+    double nbt::number() const
+    {
+        switch (type)
+        {
+            case nbt_type::FLOAT:
+            case nbt_type::DOUBLE:
+                return real;
+            case nbt_type::STRING:
+                return static_cast<double>(text.size());
+            case nbt_type::LIST:
+                return static_cast<double>(list.size());
+            case nbt_type::COMPOUND:
+                return static_cast<double>(compound.size());
+            default:
+                return static_cast<double>(integer);
+        }
+    }
+    nbt* nbt::member(const std::string& key)
+    {
+        for (auto& [name, value] : compound)
+            if (name == key)
+                return &value;
+        return nullptr;
+    }
+    bool nbt::operator==(const nbt& other) const
+    {
+        if (type != other.type)
+            return false;
+        switch (type)
+        {
+            case nbt_type::FLOAT:
+            case nbt_type::DOUBLE:
+                return real == other.real;
+            case nbt_type::STRING:
+                return text == other.text;
+            case nbt_type::LIST:
+                return list == other.list;
+            case nbt_type::COMPOUND:
+            {
+                if (compound.size() != other.compound.size())
+                    return false;
+                for (auto& [name, value] : compound)
+                {
+                    const nbt* theirs = const_cast<nbt&>(other).member(name);
+                    if (!theirs || !(*theirs == value))
+                        return false;
+                }
+                return true;
+            }
+            default:
+                return integer == other.integer;
+        }
+    }
+    std::string nbt::str() const
+    {
+        std::stringstream ss;
+        switch (type)
+        {
+            case nbt_type::BYTE:   ss << integer << 'b'; break;
+            case nbt_type::SHORT:  ss << integer << 's'; break;
+            case nbt_type::INT:    ss << integer; break;
+            case nbt_type::LONG:   ss << integer << 'L'; break;
+            case nbt_type::FLOAT:  ss << real << 'f'; break;
+            case nbt_type::DOUBLE: ss << real << 'd'; break;
+            case nbt_type::STRING:
+            {
+                ss << '"';
+                for (char c : text)
+                {
+                    if (c == '"' || c == '\\')
+                        ss << '\\';
+                    ss << c;
+                }
+                ss << '"';
+                break;
+            }
+            case nbt_type::LIST:
+            {
+                ss << '[';
+                for (size_t i = 0; i < list.size(); i++)
+                    ss << (i ? ", " : "") << list[i].str();
+                ss << ']';
+                break;
+            }
+            case nbt_type::COMPOUND:
+            {
+                ss << '{';
+                for (size_t i = 0; i < compound.size(); i++)
+                    ss << (i ? ", " : "") << compound[i].first << ": " << compound[i].second.str();
+                ss << '}';
+                break;
+            }
+        }
+        return ss.str();
+    }
+#pragma endregion nbt
+
+    // reads commands and snbt left to right.
+    struct cursor
+    {
+        const std::string& text;
+        size_t at = 0;
+        std::string error = "";
+
+        bool done()
+        {
+            skipSpaces();
+            return at >= text.size();
+        }
+        void skipSpaces()
+        {
+            while (at < text.size() && text[at] == ' ')
+                at++;
+        }
+        std::string word()
+        {
+            skipSpaces();
+            const size_t start = at;
+            while (at < text.size() && text[at] != ' ')
+                at++;
+            return text.substr(start, at - start);
+        }
+        bool accept(const std::string& w)
+        {
+            skipSpaces();
+            if (text.compare(at, w.size(), w) != 0 || (at + w.size() < text.size() && text[at + w.size()] != ' '))
+                return false;
+            at += w.size();
+            return true;
+        }
+        std::string rest()
+        {
+            skipSpaces();
+            std::string r = text.substr(std::min(at, text.size()));
+            at = text.size();
+            return r;
+        }
+        // a path runs to the next space that isn't inside brackets or quotes.
+        std::string path()
+        {
+            skipSpaces();
+            const size_t start = at;
+            int depth = 0;
+            char quote = 0;
+            for (; at < text.size(); at++)
+            {
+                const char c = text[at];
+                if (quote)
+                {
+                    if (c == '\\')
+                        at++;
+                    else if (c == quote)
+                        quote = 0;
+                }
+                else if (c == '"' || c == '\'')
+                    quote = c;
+                else if (c == '[' || c == '{')
+                    depth++;
+                else if (c == ']' || c == '}')
+                    depth--;
+                else if (c == ' ' && depth == 0)
+                    break;
+            }
+            return text.substr(start, at - start);
+        }
+
+        bool value(nbt& out)
+        {
+            skipSpaces();
+            if (at >= text.size())
+                return fail("Expected a value");
+            const char c = text[at];
+            if (c == '{')
+            {
+                at++;
+                out = nbt{};
+                out.type = nbt_type::COMPOUND;
+                skipWhitespace();
+                if (at < text.size() && text[at] == '}')
+                    return ++at, true;
+                while (true)
+                {
+                    skipWhitespace();
+                    std::string key;
+                    if (!name(key))
+                        return false;
+                    skipWhitespace();
+                    if (at >= text.size() || text[at] != ':')
+                        return fail("Expected ':'");
+                    at++;
+                    nbt member;
+                    if (!value(member))
+                        return false;
+                    out.compound.push_back({key, std::move(member)});
+                    skipWhitespace();
+                    if (at < text.size() && text[at] == ',')
+                    {
+                        at++;
+                        continue;
+                    }
+                    if (at < text.size() && text[at] == '}')
+                        return ++at, true;
+                    return fail("Expected ',' or '}'");
+                }
+            }
+            if (c == '[')
+            {
+                at++;
+                out = nbt{};
+                out.type = nbt_type::LIST;
+                skipWhitespace();
+                // typed arrays, [I; 1, 2], are read as lists.
+                if (at + 1 < text.size() && text[at + 1] == ';')
+                    at += 2;
+                skipWhitespace();
+                if (at < text.size() && text[at] == ']')
+                    return ++at, true;
+                while (true)
+                {
+                    nbt element;
+                    if (!value(element))
+                        return false;
+                    out.list.push_back(std::move(element));
+                    skipWhitespace();
+                    if (at < text.size() && text[at] == ',')
+                    {
+                        at++;
+                        continue;
+                    }
+                    if (at < text.size() && text[at] == ']')
+                        return ++at, true;
+                    return fail("Expected ',' or ']'");
+                }
+            }
+            if (c == '"' || c == '\'')
+            {
+                std::string s;
+                if (!name(s))
+                    return false;
+                out = nbt::ofString(s);
+                return true;
+            }
+            const size_t start = at;
+            while (at < text.size() && std::string(",}] \t\n:").find(text[at]) == std::string::npos)
+                at++;
+            out = scalar(text.substr(start, at - start));
+            return start != at || fail("Expected a value");
+        }
+
+    private:
+        bool fail(const std::string& message)
+        {
+            if (error.empty())
+                error = message + " at " + std::to_string(at) + " in '" + text + "'";
+            return false;
+        }
+        void skipWhitespace()
+        {
+            while (at < text.size() && std::isspace(static_cast<unsigned char>(text[at])))
+                at++;
+        }
+        // a compound key or a quoted string.
+        bool name(std::string& out)
+        {
+            skipWhitespace();
+            if (at < text.size() && (text[at] == '"' || text[at] == '\''))
+            {
+                const char quote = text[at++];
+                while (at < text.size() && text[at] != quote)
+                {
+                    if (text[at] == '\\' && at + 1 < text.size())
+                        at++;
+                    out += text[at++];
+                }
+                if (at >= text.size())
+                    return fail("Unterminated string");
+                at++;
+                return true;
+            }
+            const size_t start = at;
+            while (at < text.size() && (std::isalnum(static_cast<unsigned char>(text[at])) || std::string("_-.+").find(text[at]) != std::string::npos))
+                at++;
+            out = text.substr(start, at - start);
+            return !out.empty() || fail("Expected a name");
+        }
+        static nbt scalar(const std::string& s)
+        {
+            if (s == "true" || s == "false")
+                return nbt::ofInt(s == "true", nbt_type::BYTE);
+            size_t length = s.size();
+            nbt_type type = nbt_type::INT;
+            const char suffix = s.empty() ? 0 : std::tolower(static_cast<unsigned char>(s.back()));
+            switch (suffix)
+            {
+                case 'b': type = nbt_type::BYTE;   length--; break;
+                case 's': type = nbt_type::SHORT;  length--; break;
+                case 'l': type = nbt_type::LONG;   length--; break;
+                case 'f': type = nbt_type::FLOAT;  length--; break;
+                case 'd': type = nbt_type::DOUBLE; length--; break;
+                default: break;
+            }
+            const std::string digits = s.substr(0, length);
+            const bool real = digits.find_first_of(".eE") != std::string::npos;
+            if (real && type == nbt_type::INT)
+                type = nbt_type::DOUBLE;
+            char* end = nullptr;
+            const double parsed = std::strtod(digits.c_str(), &end);
+            if (digits.empty() || end != digits.c_str() + digits.size())
+                return nbt::ofString(s);
+            if (type == nbt_type::FLOAT || type == nbt_type::DOUBLE)
+            {
+                nbt n = nbt::ofInt(0, type);
+                n.real = parsed;
+                return n;
+            }
+            return nbt::ofInt(static_cast<long long>(parsed), type);
+        }
+    };
+
+    bool parse(const std::string& text, nbt& out, std::string& err)
+    {
+        cursor in{text};
+        if (!in.value(out))
+        {
+            err = in.error;
+            return false;
+        }
+        if (!in.done())
+        {
+            err = "Unexpected text after value in '" + text + "'";
+            return false;
+        }
+        return true;
+    }
+
+#pragma region paths
+    struct path_step
+    {
+        std::string key = "";
+        // -1 for keys. negative indices count from the end of the list.
+        bool isIndex = false;
+        long long index = 0;
+        // [{...}], the elements of a list that have every member the filter has.
+        bool isFilter = false;
+        nbt filter;
+    };
+    static bool matches(const nbt& value, const nbt& filter)
+    {
+        if (filter.type != nbt_type::COMPOUND)
+            return value == filter;
+        if (value.type != nbt_type::COMPOUND)
+            return false;
+        for (auto& [key, member] : filter.compound)
+        {
+            auto it = std::find_if(value.compound.begin(), value.compound.end(), [&](auto& m) { return m.first == key; });
+            if (it == value.compound.end() || !matches(it->second, member))
+                return false;
+        }
+        return true;
+    }
+    static bool parsePath(const std::string& text, std::vector<path_step>& steps)
+    {
+        size_t at = 0;
+        while (at < text.size())
+        {
+            if (text[at] == '.')
+            {
+                at++;
+                continue;
+            }
+            if (text[at] == '[')
+            {
+                const size_t close = text.find(']', at);
+                if (close == std::string::npos)
+                    return false;
+                const std::string inside = text.substr(at + 1, close - at - 1);
+                if (inside.empty())
+                    return false;
+                path_step step;
+                if (inside.front() == '{')
+                {
+                    std::string err;
+                    step.isFilter = true;
+                    if (!parse(inside, step.filter, err))
+                        return false;
+                    steps.push_back(step);
+                    at = close + 1;
+                    continue;
+                }
+                step.isIndex = true;
+                step.index   = std::stoll(inside);
+                steps.push_back(step);
+                at = close + 1;
+                continue;
+            }
+            path_step step;
+            if (text[at] == '"')
+            {
+                const size_t close = text.find('"', at + 1);
+                if (close == std::string::npos)
+                    return false;
+                step.key = text.substr(at + 1, close - at - 1);
+                at = close + 1;
+            }
+            else
+            {
+                const size_t end = text.find_first_of(".[", at);
+                step.key = text.substr(at, end == std::string::npos ? std::string::npos : end - at);
+                at = end == std::string::npos ? text.size() : end;
+            }
+            steps.push_back(step);
+        }
+        return true;
+    }
+    // the tag at the path, nullptr if it doesn't exist. with create, missing compounds on the way are made.
+    static nbt* resolve(nbt& root, const std::vector<path_step>& steps, bool create, size_t count)
+    {
+        nbt* at = &root;
+        for (size_t i = 0; i < count; i++)
+        {
+            const path_step& step = steps[i];
+            if (step.isFilter)
+            {
+                if (at->type != nbt_type::LIST)
+                    return nullptr;
+                auto found = std::find_if(at->list.begin(), at->list.end(), [&](const nbt& e) { return matches(e, step.filter); });
+                if (found == at->list.end())
+                    return nullptr;
+                at = &*found;
+                continue;
+            }
+            if (step.isIndex)
+            {
+                if (at->type != nbt_type::LIST)
+                    return nullptr;
+                const long long size  = at->list.size();
+                const long long index = step.index < 0 ? size + step.index : step.index;
+                if (index < 0 || index >= size)
+                    return nullptr;
+                at = &at->list[index];
+                continue;
+            }
+            if (at->type != nbt_type::COMPOUND)
+                return nullptr;
+            nbt* next = at->member(step.key);
+            if (!next)
+            {
+                if (!create)
+                    return nullptr;
+                at->compound.push_back({step.key, nbt{}});
+                next = &at->compound.back().second;
+                // a leaf made here is replaced by whatever is stored in it.
+            }
+            at = next;
+        }
+        return at;
+    }
+    static nbt* resolve(nbt& root, const std::vector<path_step>& steps, bool create = false)
+    {
+        return resolve(root, steps, create, steps.size());
+    }
+#pragma endregion paths
+
+    struct machine::frame
+    {
+        std::string location;
+        size_t line = 0;
+        const nbt* arguments = nullptr;
+    };
+
+    machine::machine(const options& opts) : _options(opts) {}
+
+    void machine::load(const mc_program& program, const std::string& ns, const std::string& globalName)
+    {
+        auto add = [&](const std::string& location, const mc_function& function)
+        {
+            std::vector<std::string>& lines = _functions[location];
+            lines.clear();
+            for (const mc_command& command : function.commands)
+                lines.push_back(command.body);
+        };
+        add(ns + ':' + globalName, program.globalFunction);
+        for (const mc_function& function : program.functions)
+            add(function.location(ns), function);
+    }
+    bool machine::load(const std::filesystem::path& datapack, std::string& err)
+    {
+        const std::filesystem::path data = datapack / "data";
+        if (!std::filesystem::is_directory(data))
+        {
+            err = "'" + datapack.string() + "' is not a datapack, it has no data folder.";
+            return false;
+        }
+        for (const auto& ns : std::filesystem::directory_iterator(data))
+        {
+            // 'functions' before 1.21.
+            for (const char* folder : {"function", "functions"})
+            {
+                const std::filesystem::path root = ns.path() / folder;
+                if (!std::filesystem::is_directory(root))
+                    continue;
+                for (const auto& file : std::filesystem::recursive_directory_iterator(root))
+                {
+                    if (file.path().extension() != ".mcfunction")
+                        continue;
+                    std::string relative = std::filesystem::relative(file.path(), root).replace_extension().generic_string();
+                    std::vector<std::string>& lines = _functions[ns.path().filename().string() + ':' + relative];
+                    lines.clear();
+                    std::ifstream in(file.path());
+                    for (std::string line; std::getline(in, line);)
+                    {
+                        if (!line.empty() && line.back() == '\r')
+                            line.pop_back();
+                        lines.push_back(line);
+                    }
+                }
+            }
+        }
+        if (_functions.empty())
+        {
+            err = "No functions found in '" + datapack.string() + "'.";
+            return false;
+        }
+        return true;
+    }
+    bool machine::has(const std::string& location) const
+    {
+        return _functions.find(location) != _functions.end();
+    }
+    std::vector<std::string> machine::locations() const
+    {
+        std::vector<std::string> all;
+        for (auto& [location, lines] : _functions)
+            all.push_back(location);
+        std::sort(all.begin(), all.end());
+        return all;
+    }
+
+    run_result machine::run(const std::string& location)
+    {
+        run_result result;
+        _run   = &result;
+        _depth = 0;
+        outcome done = has(location) ? call(location, nullptr) : outcome{false};
+        if (!has(location))
+            result.error = "Unknown function '" + location + "'.";
+        result.ok       = done.ok && result.error.empty();
+        result.returned = done.returned;
+        result.value    = done.value;
+        _run = nullptr;
+        return result;
+    }
+    std::vector<std::pair<std::string, run_result>> machine::tick()
+    {
+        _tick++;
+        std::vector<std::pair<std::string, run_result>> ran;
+        // functions scheduled while these run wait for a later tick.
+        std::vector<std::pair<long long, std::string>> due;
+        auto split = std::stable_partition(_scheduled.begin(), _scheduled.end(), [&](auto& s) { return s.first > _tick; });
+        due.assign(split, _scheduled.end());
+        _scheduled.erase(split, _scheduled.end());
+        for (auto& [when, location] : due)
+            ran.push_back({location, run(location)});
+        return ran;
+    }
+
+    machine::outcome machine::fail(frame& at, const std::string& message)
+    {
+        if (_run && _run->error.empty())
+            _run->error = at.location + ':' + std::to_string(at.line) + ": " + message;
+        return outcome{false, false};
+    }
+    std::string machine::selected(const std::string& selector) const
+    {
+        if (!selector.starts_with("@e[tag=") || !selector.ends_with(']'))
+            return selector;
+        auto tagged = _tagged.find(selector.substr(7, selector.size() - 8));
+        return tagged == _tagged.end() ? selector : tagged->second;
+    }
+
+    machine::outcome machine::call(const std::string& location, const nbt* arguments)
+    {
+        auto found = _functions.find(location);
+        frame at{location, 0, arguments};
+        if (found == _functions.end())
+            return fail(at, "Unknown function '" + location + "'.");
+        if (++_depth > _options.maxDepth)
+        {
+            _depth--;
+            return fail(at, "Calls nested deeper than " + std::to_string(_options.maxDepth) + '.');
+        }
+        calls[location]++;
+
+        outcome result;
+        const std::vector<std::string>& lines = found->second;
+        for (size_t i = 0; i < lines.size(); i++)
+        {
+            at.line = i + 1;
+            std::string line = lines[i];
+            size_t start = line.find_first_not_of(' ');
+            if (start == std::string::npos || line[start] == '#')
+                continue;
+            line.erase(0, start);
+            if (line.front() == '$')
+            {
+                if (!arguments)
+                {
+                    result = fail(at, "Macro line in a function called without arguments.");
+                    break;
+                }
+                std::string expanded, missing;
+                for (size_t k = 1; k < line.size(); k++)
+                {
+                    const size_t close = line.find(')', k);
+                    if (line.compare(k, 2, "$(") == 0 && close != std::string::npos)
+                    {
+                        const std::string key = line.substr(k + 2, close - k - 2);
+                        nbt* value = const_cast<nbt*>(arguments)->member(key);
+                        if (!value)
+                        {
+                            missing = key;
+                            break;
+                        }
+                        expanded += value->type == nbt_type::STRING ? value->text : value->str();
+                        k = close;
+                        continue;
+                    }
+                    expanded += line[k];
+                }
+                if (!missing.empty())
+                {
+                    result = fail(at, "Missing macro argument '" + missing + "'.");
+                    break;
+                }
+                line = expanded;
+            }
+
+            if (_run->commands >= _options.maxCommands)
+            {
+                _run->truncated = true;
+                result = outcome{true, false, 0, true};
+                break;
+            }
+            _run->commands++;
+            commands[location]++;
+
+            outcome done = execute(line, at);
+            if (!done.ok)
+            {
+                result = done;
+                break;
+            }
+            if (done.returned || _run->truncated)
+            {
+                result = done;
+                break;
+            }
+        }
+        _depth--;
+        return result;
+    }
+
+    machine::outcome machine::execute(const std::string& command, frame& at)
+    {
+        cursor in{command};
+        std::vector<std::string> unused;
+        const std::string verb = in.word();
+
+        auto storageAt = [&](std::vector<path_step>& steps, std::string& id) -> bool
+        {
+            if (!in.accept("storage"))
+                return false;
+            id = in.word();
+            return parsePath(in.path(), steps);
+        };
+        auto scoreOf = [&](const std::string& holder, const std::string& objective) -> int*
+        {
+            auto board = scores.find(objective);
+            if (board == scores.end())
+                return nullptr;
+            auto score = board->second.find(holder);
+            return score == board->second.end() ? nullptr : &score->second;
+        };
+
+        if (verb == "data")
+        {
+            const std::string action = in.word();
+            std::string id;
+            std::vector<path_step> steps;
+            if (action == "merge")
+            {
+                if (!in.accept("storage"))
+                    return fail(at, "Only storage is supported: " + command);
+                id = in.word();
+                nbt value;
+                if (!in.value(value) || value.type != nbt_type::COMPOUND)
+                    return fail(at, "Expected a compound: " + command);
+                nbt& root = storage[id];
+                for (auto& [key, member] : value.compound)
+                {
+                    if (nbt* existing = root.member(key))
+                        *existing = member;
+                    else
+                        root.compound.push_back({key, member});
+                }
+                return outcome{};
+            }
+            if (!storageAt(steps, id))
+                return fail(at, "Only storage is supported: " + command);
+            nbt& root = storage[id];
+            if (action == "get")
+            {
+                nbt* found = resolve(root, steps);
+                if (!found)
+                    return outcome{true, false};
+                double scale = 1;
+                if (!in.done())
+                    scale = std::stod(in.word());
+                return outcome{true, true, static_cast<int>(std::floor(found->number() * scale))};
+            }
+            if (action == "remove")
+            {
+                if (steps.empty())
+                    return fail(at, "Cannot remove a whole storage: " + command);
+                nbt* parent = resolve(root, steps, false, steps.size() - 1);
+                if (!parent)
+                    return outcome{true, false};
+                const path_step& last = steps.back();
+                if (last.isFilter)
+                {
+                    if (parent->type != nbt_type::LIST)
+                        return outcome{true, false};
+                    const size_t before = parent->list.size();
+                    std::erase_if(parent->list, [&](const nbt& e) { return matches(e, last.filter); });
+                    return outcome{true, parent->list.size() < before};
+                }
+                if (last.isIndex)
+                {
+                    if (parent->type != nbt_type::LIST)
+                        return outcome{true, false};
+                    const long long size  = parent->list.size();
+                    const long long index = last.index < 0 ? size + last.index : last.index;
+                    if (index < 0 || index >= size)
+                        return outcome{true, false};
+                    parent->list.erase(parent->list.begin() + index);
+                    return outcome{};
+                }
+                auto& members = parent->compound;
+                auto it = std::find_if(members.begin(), members.end(), [&](auto& m) { return m.first == last.key; });
+                if (it == members.end())
+                    return outcome{true, false};
+                members.erase(it);
+                return outcome{};
+            }
+            if (action == "modify")
+            {
+                const std::string how = in.word();
+                long long insertAt = 0;
+                if (how == "insert")
+                    insertAt = std::stoll(in.word());
+                nbt source;
+                if (in.accept("value"))
+                {
+                    if (!in.value(source))
+                        return fail(at, in.error);
+                }
+                else if (in.accept("from"))
+                {
+                    std::string fromId;
+                    std::vector<path_step> fromSteps;
+                    if (!storageAt(fromSteps, fromId))
+                        return fail(at, "Only storage is supported: " + command);
+                    nbt* found = resolve(storage[fromId], fromSteps);
+                    if (!found)
+                        return outcome{true, false};
+                    source = *found;
+                }
+                else
+                    return fail(at, "Expected 'value' or 'from': " + command);
+
+                if (how == "set")
+                {
+                    nbt* target = resolve(root, steps, true);
+                    if (!target)
+                        return outcome{true, false};
+                    // nothing changed is a failure, which is how comparisons are made.
+                    if (*target == source)
+                        return outcome{true, false};
+                    *target = source;
+                    return outcome{};
+                }
+                nbt* target = resolve(root, steps, true);
+                if (!target)
+                    return outcome{true, false};
+                if (how == "merge")
+                {
+                    if (target->type != nbt_type::COMPOUND || source.type != nbt_type::COMPOUND)
+                        return outcome{true, false};
+                    for (auto& [key, member] : source.compound)
+                    {
+                        if (nbt* existing = target->member(key))
+                            *existing = member;
+                        else
+                            target->compound.push_back({key, member});
+                    }
+                    return outcome{};
+                }
+                // a path made by resolve is an empty compound, it becomes the list.
+                if (target->type == nbt_type::COMPOUND && target->compound.empty())
+                    target->type = nbt_type::LIST;
+                if (target->type != nbt_type::LIST)
+                    return outcome{true, false};
+                if (how == "append")
+                    target->list.push_back(source);
+                else if (how == "prepend")
+                    target->list.insert(target->list.begin(), source);
+                else if (how == "insert")
+                {
+                    const long long size = target->list.size();
+                    const long long index = insertAt < 0 ? size + insertAt + 1 : insertAt;
+                    if (index < 0 || index > size)
+                        return outcome{true, false};
+                    target->list.insert(target->list.begin() + index, source);
+                }
+                else
+                    return fail(at, "Unsupported data modify '" + how + "'.");
+                return outcome{};
+            }
+            return fail(at, "Unsupported data command: " + command);
+        }
+        if (verb == "scoreboard")
+        {
+            const std::string group = in.word(), action = in.word();
+            if (group == "objectives")
+            {
+                const std::string name = in.word();
+                if (action == "add")
+                {
+                    if (scores.count(name))
+                        return outcome{true, false};
+                    scores[name];
+                    return outcome{};
+                }
+                if (action == "remove")
+                    return outcome{true, scores.erase(name) > 0};
+                return fail(at, "Unsupported scoreboard command: " + command);
+            }
+            if (group != "players")
+                return fail(at, "Unsupported scoreboard command: " + command);
+            const std::string holder = in.word();
+            if (action == "reset")
+            {
+                const std::string objective = in.done() ? "" : in.word();
+                for (auto& [name, board] : scores)
+                {
+                    if (!objective.empty() && objective != name)
+                        continue;
+                    if (holder == "*")
+                        board.clear();
+                    else
+                        board.erase(holder);
+                }
+                return outcome{};
+            }
+            const std::string objective = in.word();
+            auto board = scores.find(objective);
+            if (board == scores.end())
+                return outcome{true, false};
+            if (action == "get")
+            {
+                int* score = scoreOf(holder, objective);
+                return score ? outcome{true, true, *score} : outcome{true, false};
+            }
+            int& score = board->second[holder];
+            if (action == "set" || action == "add" || action == "remove")
+            {
+                const int n = std::stoi(in.word());
+                score = action == "set" ? n : action == "add" ? score + n : score - n;
+                return outcome{true, true, score};
+            }
+            if (action == "operation")
+            {
+                const std::string op = in.word(), otherHolder = in.word(), otherObjective = in.word();
+                int* other = scoreOf(otherHolder, otherObjective);
+                if (!other)
+                    return outcome{true, false};
+                const int rhs = *other;
+                if (op == "=")       score = rhs;
+                else if (op == "+=") score += rhs;
+                else if (op == "-=") score -= rhs;
+                else if (op == "*=") score *= rhs;
+                else if (op == "/=") { if (rhs) score = static_cast<int>(std::floor(static_cast<double>(score) / rhs)); }
+                else if (op == "%=") { if (rhs) score = ((score % rhs) + rhs) % rhs; }
+                else if (op == "<")  score = std::min(score, rhs);
+                else if (op == ">")  score = std::max(score, rhs);
+                else if (op == "><") std::swap(score, *other);
+                else return fail(at, "Unsupported operation '" + op + "'.");
+                return outcome{true, true, score};
+            }
+            return fail(at, "Unsupported scoreboard command: " + command);
+        }
+        if (verb == "execute")
+        {
+            // the store targets apply once the command after 'run' has run.
+            struct store_target
+            {
+                bool result;
+                std::string holder, objective;
+                std::string id;
+                std::vector<path_step> steps;
+                nbt_type type = nbt_type::INT;
+                double scale = 1;
+            };
+            std::vector<store_target> stores;
+            outcome result;
+            bool ran = false;
+            while (!in.done())
+            {
+                const std::string sub = in.word();
+                if (sub == "run")
+                {
+                    result = execute(in.rest(), at);
+                    ran = true;
+                    break;
+                }
+                if (sub == "as" || sub == "at")
+                {
+                    // there are no entities, the command runs once.
+                    in.path();
+                    continue;
+                }
+                if (sub == "store")
+                {
+                    store_target target;
+                    target.result = in.word() == "result";
+                    const std::string kind = in.word();
+                    if (kind == "score")
+                    {
+                        target.holder    = in.word();
+                        target.objective = in.word();
+                    }
+                    else if (kind == "storage")
+                    {
+                        target.id = in.word();
+                        if (!parsePath(in.path(), target.steps))
+                            return fail(at, "Unsupported path: " + command);
+                        const std::string type = in.word();
+                        target.type = type == "byte" ? nbt_type::BYTE : type == "short" ? nbt_type::SHORT :
+                                      type == "long" ? nbt_type::LONG : type == "float" ? nbt_type::FLOAT :
+                                      type == "double" ? nbt_type::DOUBLE : nbt_type::INT;
+                        target.scale = std::stod(in.word());
+                    }
+                    else
+                        return fail(at, "Unsupported store target '" + kind + "'.");
+                    stores.push_back(std::move(target));
+                    continue;
+                }
+                if (sub == "if" || sub == "unless")
+                {
+                    const bool want = sub == "if";
+                    const std::string kind = in.word();
+                    bool holds;
+                    if (kind == "score")
+                    {
+                        const std::string holder = in.word(), objective = in.word(), op = in.word();
+                        int* score = scoreOf(holder, objective);
+                        if (op == "matches")
+                        {
+                            const std::string range = in.word();
+                            const size_t dots = range.find("..");
+                            long long low = INT32_MIN, high = INT32_MAX;
+                            if (dots == std::string::npos)
+                                low = high = std::stoll(range);
+                            else
+                            {
+                                if (dots > 0)
+                                    low = std::stoll(range.substr(0, dots));
+                                if (dots + 2 < range.size())
+                                    high = std::stoll(range.substr(dots + 2));
+                            }
+                            holds = score && *score >= low && *score <= high;
+                        }
+                        else
+                        {
+                            int* other = scoreOf(in.word(), in.word());
+                            holds = score && other &&
+                                    (op == "<" ? *score < *other : op == "<=" ? *score <= *other :
+                                     op == "=" ? *score == *other : op == ">=" ? *score >= *other :
+                                     op == ">" ? *score > *other : false);
+                        }
+                    }
+                    else if (kind == "data")
+                    {
+                        std::string id;
+                        std::vector<path_step> steps;
+                        if (!storageAt(steps, id))
+                            return fail(at, "Only storage is supported: " + command);
+                        holds = resolve(storage[id], steps) != nullptr;
+                    }
+                    else
+                        return fail(at, "Unsupported condition '" + kind + "'.");
+                    if (holds != want)
+                    {
+                        result = outcome{true, false};
+                        ran = true;
+                        break;
+                    }
+                    continue;
+                }
+                return fail(at, "Unsupported execute subcommand '" + sub + "'.");
+            }
+            if (!result.ok)
+                return result;
+            if (!ran)
+                result = outcome{true, true, 1};
+            for (store_target& target : stores)
+            {
+                const int stored = target.result ? (result.success ? result.value : 0) : (result.success ? 1 : 0);
+                if (!target.objective.empty())
+                {
+                    auto board = scores.find(target.objective);
+                    if (board != scores.end())
+                        board->second[target.holder] = stored;
+                    continue;
+                }
+                nbt* into = resolve(storage[target.id], target.steps, true);
+                if (!into)
+                    continue;
+                const double scaled = stored * target.scale;
+                if (target.type == nbt_type::FLOAT || target.type == nbt_type::DOUBLE)
+                {
+                    *into = nbt::ofInt(0, target.type);
+                    into->real = scaled;
+                }
+                else
+                    *into = nbt::ofInt(static_cast<long long>(std::floor(scaled)), target.type);
+            }
+            return result;
+        }
+        if (verb == "function")
+        {
+            const std::string location = in.word();
+            if (in.accept("with"))
+            {
+                std::string id;
+                std::vector<path_step> steps;
+                if (!storageAt(steps, id))
+                    return fail(at, "Only storage is supported: " + command);
+                nbt* arguments = resolve(storage[id], steps);
+                if (!arguments || arguments->type != nbt_type::COMPOUND)
+                    return outcome{true, false};
+                // copied, the function may change the storage it came from.
+                const nbt copy = *arguments;
+                outcome called = call(location, &copy);
+                return outcome{called.ok, called.success, called.value};
+            }
+            outcome called = call(location, nullptr);
+            return outcome{called.ok, called.success, called.value};
+        }
+        if (verb == "return")
+        {
+            if (in.accept("fail"))
+                return outcome{true, false, 0, true};
+            if (in.accept("run"))
+            {
+                outcome ran = execute(in.rest(), at);
+                ran.returned = true;
+                return ran;
+            }
+            return outcome{true, true, std::stoi(in.word()), true};
+        }
+        if (verb == "schedule")
+        {
+            if (!in.accept("function"))
+                return fail(at, "Unsupported schedule command: " + command);
+            const std::string location = in.word(), time = in.word();
+            long long ticks = std::stoll(time);
+            if (time.ends_with('s'))
+                ticks *= 20;
+            else if (time.ends_with('d'))
+                ticks *= 24000;
+            const bool replace = in.done() || in.word() != "append";
+            if (replace)
+                std::erase_if(_scheduled, [&](auto& s) { return s.second == location; });
+            _scheduled.push_back({_tick + std::max(1LL, ticks), location});
+            return outcome{};
+        }
+        if (verb == "tellraw")
+        {
+            in.path();
+            nbt message;
+            if (!in.value(message))
+                return fail(at, in.error);
+            std::function<std::string(nbt&)> text = [&](nbt& component) -> std::string
+            {
+                if (component.type == nbt_type::STRING)
+                    return component.text;
+                if (component.type == nbt_type::LIST)
+                {
+                    std::string joined;
+                    for (nbt& part : component.list)
+                        joined += text(part);
+                    return joined;
+                }
+                if (component.type != nbt_type::COMPOUND)
+                    return component.str();
+                std::string out;
+                if (nbt* t = component.member("text"))
+                    out += t->type == nbt_type::STRING ? t->text : t->str();
+                if (nbt* path = component.member("nbt"))
+                {
+                    nbt* id = component.member("storage");
+                    std::vector<path_step> steps;
+                    if (id && parsePath(path->text, steps))
+                        if (nbt* found = resolve(storage[id->text], steps))
+                            out += found->type == nbt_type::STRING ? found->text : found->str();
+                }
+                if (nbt* score = component.member("score"))
+                {
+                    nbt* name = score->member("name");
+                    nbt* objective = score->member("objective");
+                    if (name && objective)
+                        if (int* value = scoreOf(name->text, objective->text))
+                            out += std::to_string(*value);
+                }
+                // there are no entities, a selector prints as itself.
+                if (nbt* selector = component.member("selector"))
+                    out += selected(selector->text);
+                if (nbt* extra = component.member("extra"))
+                    out += text(*extra);
+                return out;
+            };
+            output.push_back(text(message));
+            return outcome{};
+        }
+        if (verb == "kill")
+        {
+            output.push_back("kill " + selected(in.rest()));
+            return outcome{};
+        }
+        if (verb == "tag")
+        {
+            const std::string selector = in.path(), action = in.word(), name = in.word();
+            if (action == "add")
+                _tagged[name] = selected(selector);
+            else if (action == "remove")
+                _tagged.erase(name);
+            else
+                return fail(at, "Unsupported tag command: " + command);
+            return outcome{};
+        }
+        return fail(at, "Unsupported command '" + verb + "'.");
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+#include <cstdint>
+#include "mc.hpp"
+
+// runs compiled programs without minecraft: the commands CommandFactory emits (data storage, scoreboard,
+// execute if/unless/store, function with macros, return, schedule, tellraw) against in-memory storage and
+// scoreboards. entities don't exist, 'execute as/at' runs its command once, 'kill' is only recorded and
+// a 'tag' stands for the selector it was added with.
+namespace sim
+{
+    enum class nbt_type
+    {
+        BYTE, SHORT, INT, LONG, FLOAT, DOUBLE, STRING, LIST, COMPOUND
+    };
+    struct nbt
+    {
+        nbt_type type = nbt_type::COMPOUND;
+        long long integer = 0;
+        double real = 0;
+        std::string text = "";
+        std::vector<nbt> list;
+        // in insertion order, like minecraft prints them.
+        std::vector<std::pair<std::string, nbt>> compound;
+
+        static nbt ofInt(long long value, nbt_type type = nbt_type::INT);
+        static nbt ofString(const std::string& value);
+
+        bool numeric() const;
+        // the value 'data get' returns at scale 1.
+        double number() const;
+        nbt* member(const std::string& key);
+        bool operator==(const nbt& other) const;
+        // snbt, as minecraft writes it in chat and in macro arguments.
+        std::string str() const;
+    };
+    // parses snbt (json is snbt too). returns false and sets err if text isn't one whole value.
+    bool parse(const std::string& text, nbt& out, std::string& err);
+
+    struct options
+    {
+        // minecraft's maxCommandChainLength: a run stops after this many commands.
+        size_t maxCommands = 65536;
+        // nested function calls before a run is stopped.
+        size_t maxDepth    = 1024;
+    };
+    // result of running one function and everything it called.
+    struct run_result
+    {
+        bool ok = true;
+        // the command that could not be run, as '<location>:<line>: <message>'.
+        std::string error = "";
+        size_t commands = 0;
+        bool truncated  = false;
+        // the function's return value, if it returned one.
+        bool returned   = false;
+        int value       = 0;
+    };
+
+    class machine
+    {
+    public:
+        explicit machine(const options& opts = {});
+
+        // makes the functions of a program runnable. the global function is named '<ns>:<globalName>'.
+        void load(const mc_program& program, const std::string& ns, const std::string& globalName);
+        // loads every .mcfunction of a written datapack.
+        bool load(const std::filesystem::path& datapack, std::string& err);
+        bool has(const std::string& location) const;
+        std::vector<std::string> locations() const;
+
+        run_result run(const std::string& location);
+        // advances one game tick, running whatever was scheduled for it. one result per function run.
+        std::vector<std::pair<std::string, run_result>> tick();
+        size_t pending() const { return _scheduled.size(); }
+
+        // what tellraw printed and what kill was asked to kill, in order.
+        std::vector<std::string> output;
+        // commands run in each function itself, and how often it was called, since the machine was made.
+        std::unordered_map<std::string, size_t> commands, calls;
+
+        std::unordered_map<std::string, nbt> storage;
+        std::unordered_map<std::string, std::unordered_map<std::string, int>> scores;
+
+    private:
+        struct outcome
+        {
+            bool ok       = true;
+            bool success  = true;
+            int  value    = 0;
+            // 'return' ran, the function ends here.
+            bool returned = false;
+        };
+        struct frame;
+
+        options _options;
+        std::unordered_map<std::string, std::vector<std::string>> _functions;
+        std::vector<std::pair<long long, std::string>> _scheduled;
+        long long _tick = 0;
+        // there are no entities to tag, a tag stands for the selector it was added with.
+        std::unordered_map<std::string, std::string> _tagged;
+        run_result* _run = nullptr;
+        size_t _depth    = 0;
+
+        outcome call(const std::string& location, const nbt* arguments);
+        outcome execute(const std::string& command, frame& at);
+        outcome fail(frame& at, const std::string& message);
+        // what a selector of only a tag was tagged from, the selector itself otherwise.
+        std::string selected(const std::string& selector) const;
+    };
+}
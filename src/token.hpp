@@ -33,6 +33,7 @@ enum class token_type
     COMPARE_EQUAL,
     COMPARE_NOTEQUAL,
     MODULE_ACCESS,
+    RANGE, // ..
 
     SYMBOL,
 
@@ -67,6 +68,7 @@ enum class token_type
     KW_IN,
     KW_BREAK,
     KW_CONTINUE,
+    KW_YIELD,
 
     KW_ASM,
     KW_NULL,
@@ -11,6 +11,7 @@
 #include <iomanip>
 
 #include <type_traits>
+#include <cstdint>
 
 inline std::string removeSpecialCharacters(const std::string &input)
 {
@@ -109,13 +110,74 @@ namespace util
     {
         return T(t);
     }
-    inline std::string hashToHex(const std::string &input)
+    // 64 bit FNV-1a. unlike std::hash, this gives the same value on every
+    // standard library and build, so generated names are reproducible.
+    inline uint64_t stableHash(const std::string &input, uint64_t seed = 0xcbf29ce484222325ULL)
+    {
+        uint64_t hash = seed;
+        for (unsigned char c : input)
+        {
+            hash ^= c;
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+    inline std::string hashToHex(uint64_t hashValue)
     {
-        std::hash<std::string> hasher;
-        size_t hashValue = hasher(input);
-
         std::stringstream ss;
-        ss << std::hex << std::setw(sizeof(size_t) * 2) << std::setfill('0') << hashValue;
+        ss << std::hex << std::setw(sizeof(uint64_t) * 2) << std::setfill('0') << hashValue;
         return ss.str();
     }
+    inline std::string hashToHex(const std::string &input)
+    {
+        return hashToHex(stableHash(input));
+    }
+    // resolves the escapes a string literal keeps from source (\" \\ \n \t \r), unknown escapes keep their character.
+    inline std::string unescape(const std::string &input)
+    {
+        std::string output;
+        for (size_t i = 0; i < input.size(); i++)
+        {
+            char c = input[i];
+            if (c != '\\' || i + 1 == input.size())
+            {
+                output += c;
+                continue;
+            }
+            switch (c = input[++i])
+            {
+                case 'n': output += '\n'; break;
+                case 't': output += '\t'; break;
+                case 'r': output += '\r'; break;
+                default:  output += c;    break;
+            }
+        }
+        return output;
+    }
+    // a quoted json string, every '"', '\' and control character escaped.
+    inline std::string jsonString(const std::string &input)
+    {
+        std::string output = "\"";
+        for (unsigned char c : input)
+        {
+            switch (c)
+            {
+                case '"':  output += "\\\""; break;
+                case '\\': output += "\\\\"; break;
+                case '\n': output += "\\n";  break;
+                case '\t': output += "\\t";  break;
+                case '\r': output += "\\r";  break;
+                default:
+                    if (c < 0x20)
+                    {
+                        std::stringstream ss;
+                        ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c);
+                        output += ss.str();
+                    }
+                    else
+                        output += char(c);
+            }
+        }
+        return output + '"';
+    }
 }